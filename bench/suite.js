@@ -0,0 +1,121 @@
+// The benchmark suite behind `make bench`: the runtime microbenchmarks in runtime-lib/bench, and how
+// long the CLI takes to compile some of the examples and how long the results take to run.
+//
+//   --save <file>        Write the results to <file> as JSON.
+//   --baseline <file>    Compare against results saved earlier, and exit with status 1 if anything
+//                        got slower by more than the threshold.
+//   --threshold <ratio>  How much slower counts as a regression. Defaults to 0.1, that is 10%.
+
+import { spawnSync } from 'node:child_process';
+import * as fs from 'node:fs';
+import { tmpdir } from 'node:os';
+import * as path from 'node:path';
+import { parseArgs } from 'node:util';
+import { time } from './time.js';
+
+// Examples that finish on their own without reading input.
+const PROGRAMS = ['brainfuck', 'primes', 'array', 'for', 'runtime_strings'];
+const RUNS = 5;
+
+const { values: options } = parseArgs({
+  options: {
+    save: { type: 'string' },
+    baseline: { type: 'string' },
+    threshold: { type: 'string', default: '0.1' },
+  },
+});
+const threshold = Number(options.threshold);
+if (!(threshold >= 0)) {
+  throw new Error(`Invalid threshold: ${options.threshold}`);
+}
+
+const root = path.join(import.meta.dirname, '..');
+const falafel = path.join(root, 'dist', 'bin', 'falafel');
+const micro = path.join(root, 'runtime-lib', 'bench', 'micro');
+
+// A release build of the CLI compiles against the installed runtime, so point it and the programs
+// it builds at the one in dist/ instead. The CLI splits these flags on spaces, so the checkout's
+// path can't contain any.
+const dist = path.join(root, 'dist');
+const prependEnv = (name, value, separator) => {
+  process.env[name] = process.env[name] ? `${value}${separator}${process.env[name]}` : value;
+};
+prependEnv('CPPFLAGS', `-I${path.join(dist, 'include')}`, ' ');
+prependEnv('LDFLAGS', `-L${path.join(dist, 'lib')}`, ' ');
+prependEnv('LD_LIBRARY_PATH', path.join(dist, 'lib'), ':');
+
+// Every result is a time where lower is better, keyed by a name that stays the same between runs.
+const results = {};
+const record = (name, value, unit) => {
+  results[name] = { value, unit };
+  console.log(`${name.padEnd(36)} ${value.toFixed(2).padStart(10)} ${unit}`);
+};
+
+const runMicrobenchmarks = () => {
+  const { status, stdout } = spawnSync(micro, {
+    stdio: ['ignore', 'pipe', 'inherit'],
+    encoding: 'utf8',
+  });
+  if (status !== 0) {
+    throw new Error(`${micro} exited with status ${status}`);
+  }
+  for (const line of stdout.split('\n')) {
+    const match = /^(\S+)\s+(\S+) (\S+)$/.exec(line);
+    if (match) {
+      record(`runtime/${match[1]}`, Number(match[2]), match[3]);
+    }
+  }
+};
+
+const runPrograms = () => {
+  const dir = fs.mkdtempSync(path.join(tmpdir(), 'falafel-bench-'));
+  try {
+    for (const program of PROGRAMS) {
+      const source = path.join(root, 'examples', program);
+      const executable = path.join(dir, program);
+      // Without the cache, every run after the first would only be timing a cache hit.
+      const compile = time(RUNS, falafel, ['--no-cache', '-O2', '-o', executable, source]);
+      record(`compile/${program}`, compile, 'ms');
+      record(`run/${program}`, time(RUNS, executable, []), 'ms');
+    }
+  } finally {
+    fs.rmSync(dir, { recursive: true });
+  }
+};
+
+// Returns whether nothing regressed.
+const compare = (baseline) => {
+  let passed = true;
+  console.log(`\ncompared with ${options.baseline}, regressions over ${threshold * 100}% marked`);
+  for (const [name, { value, unit }] of Object.entries(results)) {
+    const before = baseline[name];
+    if (before === undefined || before.unit !== unit) {
+      console.log(`${name.padEnd(36)} (new)`);
+      continue;
+    }
+    const change = value / before.value - 1;
+    const regressed = change > threshold;
+    passed &&= !regressed;
+    const percent = `${change >= 0 ? '+' : ''}${(change * 100).toFixed(1)}%`;
+    console.log(`${name.padEnd(36)} ${percent.padStart(10)}${regressed ? '  REGRESSION' : ''}`);
+  }
+  for (const name of Object.keys(baseline)) {
+    if (!(name in results)) {
+      console.log(`${name.padEnd(36)} (missing)`);
+    }
+  }
+  return passed;
+};
+
+runMicrobenchmarks();
+runPrograms();
+
+if (options.save) {
+  fs.writeFileSync(options.save, `${JSON.stringify(results, null, 2)}\n`);
+}
+if (options.baseline) {
+  const baseline = JSON.parse(fs.readFileSync(options.baseline, 'utf8'));
+  if (!compare(baseline)) {
+    process.exitCode = 1;
+  }
+}
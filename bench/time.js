@@ -0,0 +1,24 @@
+import { spawnSync } from 'node:child_process';
+import * as fs from 'node:fs';
+
+// The fastest of several runs of `executable`, in milliseconds. Its output goes to the file
+// `stdout` if given, and is discarded otherwise.
+export const time = (runs, executable, args, stdout) => {
+  let best = Infinity;
+  for (let i = 0; i < runs; ++i) {
+    const output = stdout ? fs.openSync(stdout, 'w') : 'ignore';
+    const start = process.hrtime.bigint();
+    const { status } = spawnSync(executable, args, {
+      stdio: ['ignore', output, 'inherit'],
+    });
+    const elapsed = Number(process.hrtime.bigint() - start) / 1e6;
+    if (typeof output === 'number') {
+      fs.closeSync(output);
+    }
+    if (status !== 0) {
+      throw new Error(`${executable} exited with status ${status}`);
+    }
+    best = Math.min(best, elapsed);
+  }
+  return best;
+};
@@ -0,0 +1,135 @@
+using Compiler.Components;
+using Compiler.Models;
+using FluentAssertions;
+
+namespace Compiler.Tests;
+
+public class CodegenTests
+{
+    [Fact]
+    public void Codegen_RangeLoopCounterAvoidsProgramNames()
+    {
+        // for i in 0..<3 { loop0 = i }, where loop0 and loop1 are the program's own variables.
+        var loop0 = new TypeCheckedIdentifier { Name = "loop0", Type = BuiltIns.Int };
+        List<TypeCheckedStatement> program =
+        [
+            new TypeCheckedVar
+            {
+                Name = "loop0",
+                Type = BuiltIns.Int,
+                Value = Int(5),
+            },
+            new TypeCheckedVar
+            {
+                Name = "loop1",
+                Type = BuiltIns.Int,
+                Value = Int(6),
+            },
+            new TypeCheckedRangeLoop
+            {
+                Variable = "i",
+                VariableType = BuiltIns.Int,
+                Start = Int(0),
+                End = Int(3),
+                Body =
+                [
+                    new TypeCheckedAssignment
+                    {
+                        Lhs = loop0,
+                        Rhs = new TypeCheckedIdentifier { Name = "i", Type = BuiltIns.Int },
+                    },
+                ],
+            },
+        ];
+
+        var code = Generate(program);
+
+        code.Should()
+            .Contain("for (Int loop2 = (Int)0, loopEnd3 = (Int)3; loop2 < loopEnd3; ++loop2)")
+            .And.Contain("Int i = loop2;loop0 = i;");
+    }
+
+    [Fact]
+    public void Codegen_OnlyTopLevelFunctionsHaveExternalLinkage()
+    {
+        // func run(): Void { func helper(): Void {} helper() }, where another module may declare
+        // a helper() of its own.
+        var helper = new Method { Name = "helper", ReturnType = BuiltIns.Void };
+        var run = new Method { Name = "run", ReturnType = BuiltIns.Void };
+        List<TypeCheckedStatement> program =
+        [
+            new TypeCheckedFunctionDeclaration
+            {
+                Method = run,
+                Arguments = [],
+                Body =
+                [
+                    new TypeCheckedFunctionDeclaration
+                    {
+                        Method = helper,
+                        Arguments = [],
+                        Body = [],
+                    },
+                    new TypeCheckedFunctionCall { Method = helper, Arguments = [] },
+                ],
+            },
+        ];
+
+        var code = Generate(program);
+
+        code.Should()
+            .Contain("static Void f_helpervb()")
+            .And.Contain("Void f_runvb()")
+            .And.NotContain("static Void f_runvb()");
+    }
+
+    [Fact]
+    public void Codegen_SizedIntegerArithmeticIsUnsigned()
+    {
+        // a * a and -b, where a is a UInt16 and b is an Int32. Done in int, the product could
+        // overflow, and so could negating int's smallest value.
+        var a = new TypeCheckedIdentifier { Name = "a", Type = BuiltIns.UInt16 };
+        var b = new TypeCheckedIdentifier { Name = "b", Type = BuiltIns.Int32 };
+        List<TypeCheckedStatement> program =
+        [
+            new TypeCheckedOperatorCall
+            {
+                Operator = BuiltIns.Operators.Single(o =>
+                    o.Name == "*" && o.Fixity == OperatorFixity.Infix && o.LhsType == a.Type
+                ),
+                Lhs = a,
+                Rhs = a,
+            },
+            new TypeCheckedOperatorCall
+            {
+                Operator = BuiltIns.Operators.Single(o =>
+                    o.Name == "-" && o.Fixity == OperatorFixity.Prefix && o.RhsType == b.Type
+                ),
+                Rhs = b,
+            },
+        ];
+
+        var code = Generate(program);
+
+        code.Should()
+            .Contain("static_cast<UInt16>(static_cast<unsigned>((a) )*static_cast<unsigned>( (a)))")
+            .And.Contain("static_cast<Int32>(0U-static_cast<UInt32>( (b)))");
+    }
+
+    private static TypedIntegerLiteral Int(long value) =>
+        new() { Type = BuiltIns.Int, Value = value };
+
+    private static string Generate(List<TypeCheckedStatement> program)
+    {
+        var path = Path.GetTempFileName();
+        try
+        {
+            new Codegen().GenerateCode(program, path);
+            return File.ReadAllText(path);
+        }
+        finally
+        {
+            File.Delete(path);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+using Compiler.Components;
+using Compiler.Models;
+using FluentAssertions;
+
+namespace Compiler.Tests;
+
+public class ModuleCompilerTests
+{
+    [Fact]
+    public void ModuleCompiler_WritesATranslationUnitPerModule()
+    {
+        var modules = new Dictionary<string, AstRoot>
+        {
+            ["main.falafel"] = Module(Call("greet", Str("world"))),
+            ["greet.falafel"] = Module(Function("greet", "String")),
+        };
+
+        var files = Compile(modules);
+
+        files.Keys.Should().BeEquivalentTo("module0.cpp", "module1.cpp");
+        // Only the main module has `main`, and it declares the function the other one defines.
+        files["module0.cpp"].Should().Contain("int main(").And.Contain("f_greet");
+        files["module1.cpp"].Should().NotContain("int main(").And.Contain("f_greet");
+    }
+
+    [Fact]
+    public void ModuleCompiler_RejectsOtherStatementsOutsideTheMainModule()
+    {
+        var modules = new Dictionary<string, AstRoot>
+        {
+            ["main.falafel"] = Module(),
+            ["lib.falafel"] = Module(Function("greet", "String"), Call("greet", Str("world"))),
+        };
+
+        Action compile = () => Compile(modules);
+
+        compile
+            .Should()
+            .Throw<TypeCheckException>()
+            .WithMessage("lib.falafel: Only functions can be declared*");
+    }
+
+    [Fact]
+    public void ModuleCompiler_RejectsOverlappingFunctionsInDifferentModules()
+    {
+        var modules = new Dictionary<string, AstRoot>
+        {
+            ["main.falafel"] = Module(Function("describe", "Int")),
+            ["lib.falafel"] = Module(Function("describe", "Int")),
+        };
+
+        Action compile = () => Compile(modules);
+
+        compile.Should().Throw<TypeCheckException>().WithMessage("*Possible duplicate declaration*");
+    }
+
+    [Fact]
+    public void ModuleCompiler_ReportsTheFirstModuleToFail()
+    {
+        // The modules are checked in parallel, but whichever finishes first, the error reported is
+        // always the one from the earliest module.
+        var modules = new Dictionary<string, AstRoot> { ["main.falafel"] = Module() };
+        for (var i = 1; i <= 8; ++i)
+        {
+            modules[$"lib{i}.falafel"] = Module(Call("print", Str("hi")));
+        }
+
+        for (var attempt = 0; attempt < 10; ++attempt)
+        {
+            Action compile = () => Compile(modules);
+
+            compile.Should().Throw<TypeCheckException>().WithMessage("lib1.falafel: *");
+        }
+    }
+
+    // Compiles `modules` into a new directory, returning the files written there by name.
+    private static Dictionary<string, string> Compile(Dictionary<string, AstRoot> modules)
+    {
+        var directory = Directory.CreateTempSubdirectory();
+        try
+        {
+            new ModuleCompiler(modules, warnings: TextWriter.Null).Compile(directory.FullName);
+            return directory
+                .EnumerateFiles()
+                .ToDictionary(f => f.Name, f => File.ReadAllText(f.FullName));
+        }
+        finally
+        {
+            directory.Delete(recursive: true);
+        }
+    }
+
+    private static AstRoot Module(params AstNode[] statements) =>
+        new() { Ast = statements, LineCounts = [] };
+
+    private static FunctionDeclaration Function(string name, string argumentType) =>
+        new()
+        {
+            Type = "FunctionDeclaration",
+            Name = name,
+            Arguments =
+            [
+                new() { Name = "value", Type = new() { Name = argumentType, Arguments = [] } },
+            ],
+            Body = [],
+        };
+
+    private static FunctionCall Call(string function, params Expression[] arguments) =>
+        new()
+        {
+            Type = "FunctionCall",
+            Function = function,
+            Arguments = arguments,
+        };
+
+    private static StringLiteral Str(string value) =>
+        new() { Type = "StringLiteral", Value = value };
+}
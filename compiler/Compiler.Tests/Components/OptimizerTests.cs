@@ -0,0 +1,521 @@
+using Compiler.Components;
+using Compiler.Components.Passes;
+using Compiler.Models;
+using Compiler.Util;
+using FluentAssertions;
+
+namespace Compiler.Tests;
+
+// Each test prints a small program before and after a pass, so the expected strings double as a
+// record of what the pass does.
+public class OptimizerTests
+{
+    private static readonly Models.Type IntArray = BuiltIns.Array.Instantiate([BuiltIns.Int]);
+
+    [Fact]
+    public void ConstantFolding_PropagatesConstantsIntoInterpolations()
+    {
+        var x = Id("x", BuiltIns.Int);
+        var greeting = Id("greeting", BuiltIns.String);
+        List<TypeCheckedStatement> program =
+        [
+            Var(x, Int(6)),
+            Var(greeting, Interpolate(x, Str(" apples"))),
+            Print(Interpolate(greeting, Str(": "), Op(x, "*", Int(7)))),
+        ];
+
+        IrPrinter
+            .Print(program)
+            .Should()
+            .Be(
+                """
+                var x: Int = 6
+                var greeting: String = `${x} apples`
+                print(`${greeting}: ${(x * 7)}`)
+
+                """
+            );
+
+        IrPrinter
+            .Print(new ConstantFolding().Run(program))
+            .Should()
+            .Be(
+                """
+                var x: Int = 6
+                var greeting: String = "6 apples"
+                print("6 apples: 42")
+
+                """
+            );
+    }
+
+    [Fact]
+    public void ConstantFolding_LeavesAssignedVariablesAndOverflowAlone()
+    {
+        var big = Id("big", BuiltIns.Int);
+        var n = Id("n", BuiltIns.Int);
+        List<TypeCheckedStatement> program =
+        [
+            Var(big, Int(2_000_000_000)),
+            Var(n, Int(1)),
+            Assign(n, Op(n, "+", Int(1))),
+            Print(Interpolate(Op(big, "+", big), Str(" "), n)),
+        ];
+
+        IrPrinter
+            .Print(new ConstantFolding().Run(program))
+            .Should()
+            .Be(
+                """
+                var big: Int = 2000000000
+                var n: Int = 1
+                n = (n + 1)
+                print(`${(2000000000 + 2000000000)} ${n}`)
+
+                """
+            );
+    }
+
+    [Fact]
+    public void DeadCodeElimination_RemovesUnreachableAndUnusedCode()
+    {
+        var unused = Id("unused", BuiltIns.Int);
+        var s = Id("s", BuiltIns.String);
+        List<TypeCheckedStatement> program =
+        [
+            Var(unused, Int(1)),
+            Var(s, Str("abc")),
+            Assign(s, Str("def")),
+            Assign(s, Str("ghi")),
+            If(Bool(false), [Print(Str("never"))], [Print(s)]),
+            Call(s, "length"),
+        ];
+
+        IrPrinter
+            .Print(program)
+            .Should()
+            .Be(
+                """
+                var unused: Int = 1
+                var s: String = "abc"
+                s = "def"
+                s = "ghi"
+                if false {
+                    print("never")
+                } else {
+                    print(s)
+                }
+                s.length()
+
+                """
+            );
+
+        IrPrinter
+            .Print(new DeadCodeElimination().Run(program))
+            .Should()
+            .Be(
+                """
+                var s: String = "ghi"
+                print(s)
+
+                """
+            );
+    }
+
+    [Fact]
+    public void LoopInvariantHoisting_HoistsCallsOnUnchangedReceivers()
+    {
+        var s = Id("s", BuiltIns.String);
+        var i = Id("i", BuiltIns.Int);
+        List<TypeCheckedStatement> program =
+        [
+            Var(s, Str("hello")),
+            Var(i, Int(0)),
+            While(Op(i, "<", Call(s, "length")), [Assign(i, Op(i, "+", Int(1)))]),
+        ];
+
+        IrPrinter
+            .Print(new LoopInvariantHoisting(new TemporaryNames(program)).Run(program))
+            .Should()
+            .Be(
+                """
+                var s: String = "hello"
+                var i: Int = 0
+                var licm0: Int = s.length()
+                while (i < licm0) {
+                    i = (i + 1)
+                }
+
+                """
+            );
+    }
+
+    [Fact]
+    public void LoopInvariantHoisting_LeavesCallsOnMutatedReceivers()
+    {
+        var a = Id("a", IntArray);
+        List<TypeCheckedStatement> program =
+        [
+            Var(a, new TypeCheckedArrayLiteral { Values = [], Type = IntArray }),
+            While(Op(Call(a, "length"), "<", Int(3)), [Call(a, "push", Int(0))]),
+        ];
+
+        IrPrinter
+            .Print(new LoopInvariantHoisting(new TemporaryNames(program)).Run(program))
+            .Should()
+            .Be(
+                """
+                var a: Array<Int> = [] as Array<Int>
+                while (a.length() < 3) {
+                    a.push(0)
+                }
+
+                """
+            );
+    }
+
+    [Fact]
+    public void LoopInvariantHoisting_LeavesFunctionsDeclaredInTheLoopAlone()
+    {
+        // `f`'s argument shadows `s`, so its `s.length()` isn't the hoisted call.
+        var s = Id("s", BuiltIns.String);
+        var i = Id("i", BuiltIns.Int);
+        var f = new Method
+        {
+            Name = "f",
+            ArgumentTypes = [BuiltIns.String],
+            ReturnType = BuiltIns.Int,
+        };
+        List<TypeCheckedStatement> program =
+        [
+            Var(s, Str("hello")),
+            Var(i, Int(0)),
+            While(
+                Op(i, "<", Int(3)),
+                [
+                    new TypeCheckedFunctionDeclaration
+                    {
+                        Method = f,
+                        Arguments = [new() { Name = "s", Type = BuiltIns.String }],
+                        Body = [new TypeCheckedReturnStatement { Value = Call(s, "length") }],
+                    },
+                    Print(Interpolate(Call(s, "length"))),
+                    Assign(i, Op(i, "+", Int(1))),
+                ]
+            ),
+        ];
+
+        IrPrinter
+            .Print(new LoopInvariantHoisting(new TemporaryNames(program)).Run(program))
+            .Should()
+            .Be(
+                """
+                var s: String = "hello"
+                var i: Int = 0
+                var licm0: Int = s.length()
+                while (i < 3) {
+                    func f(s: String): Int {
+                        return s.length()
+                    }
+                    print(`${licm0}`)
+                    i = (i + 1)
+                }
+
+                """
+            );
+    }
+
+    [Fact]
+    public void CommonSubexpressionElimination_ReusesIndexAcrossBranches()
+    {
+        var program = Id("program", BuiltIns.String);
+        var i = Id("i", BuiltIns.Int);
+        var n = Id("n", BuiltIns.Int);
+        List<TypeCheckedStatement> statements =
+        [
+            If(
+                Op(Index(program, i), "==", Char('+')),
+                [Assign(n, Op(n, "+", Int(1)))],
+                [If(Op(Index(program, i), "==", Char('-')), [Assign(n, Op(n, "-", Int(1)))])]
+            ),
+        ];
+
+        IrPrinter
+            .Print(statements)
+            .Should()
+            .Be(
+                """
+                if (program[i] == '+') {
+                    n = (n + 1)
+                } else {
+                    if (program[i] == '-') {
+                        n = (n - 1)
+                    }
+                }
+
+                """
+            );
+
+        IrPrinter
+            .Print(
+                new CommonSubexpressionElimination(new TemporaryNames(statements)).Run(statements)
+            )
+            .Should()
+            .Be(
+                """
+                var cse0: Char = program[i]
+                if (cse0 == '+') {
+                    n = (n + 1)
+                } else {
+                    if (cse0 == '-') {
+                        n = (n - 1)
+                    }
+                }
+
+                """
+            );
+    }
+
+    [Fact]
+    public void CommonSubexpressionElimination_StopsAtAssignments()
+    {
+        var a = Id("a", IntArray);
+        var i = Id("i", BuiltIns.Int);
+        List<TypeCheckedStatement> program =
+        [
+            Print(Interpolate(Index(a, i))),
+            Assign(i, Op(i, "+", Int(1))),
+            Print(Interpolate(Index(a, i))),
+            Print(Interpolate(Index(a, i))),
+        ];
+
+        IrPrinter
+            .Print(new CommonSubexpressionElimination(new TemporaryNames(program)).Run(program))
+            .Should()
+            .Be(
+                """
+                print(`${a[i]}`)
+                i = (i + 1)
+                var cse0: Int = a[i]
+                print(`${cse0}`)
+                print(`${cse0}`)
+
+                """
+            );
+    }
+
+    [Fact]
+    public void Optimizer_RunsEveryPass()
+    {
+        var program = Id("program", BuiltIns.String);
+        var i = Id("i", BuiltIns.Int);
+        var debug = Id("debug", BuiltIns.Bool);
+        List<TypeCheckedStatement> statements =
+        [
+            Var(program, Str("+.")),
+            Var(debug, Bool(false)),
+            Var(i, Int(0)),
+            While(
+                Op(i, "<", Call(program, "length")),
+                [
+                    If(debug, [Print(Interpolate(Str("at "), i))]),
+                    If(Op(Index(program, i), "==", Char('.')), [Print(Str("dot"))]),
+                    If(Op(Index(program, i), "==", Char('+')), [Print(Str("plus"))]),
+                    Assign(i, Op(i, "+", Int(1))),
+                ]
+            ),
+        ];
+
+        IrPrinter
+            .Print(new Optimizer().Optimize(statements))
+            .Should()
+            .Be(
+                """
+                var i: Int = 0
+                var licm0: Int = "+.".length()
+                while (i < licm0) {
+                    var cse1: Char = "+."[i]
+                    if (cse1 == '.') {
+                        print("dot")
+                    }
+                    if (cse1 == '+') {
+                        print("plus")
+                    }
+                    i = (i + 1)
+                }
+
+                """
+            );
+    }
+
+    [Fact]
+    public void Optimizer_WalksVariablesDeclaredInNestedBlocks()
+    {
+        // Each pass walks the blocks again, which used to re-run the type checker over them and
+        // report the block's own variables as redeclared.
+        List<AstNode> program =
+        [
+            AstVar("i", "Int", AstInt(0)),
+            new LoopStatement
+            {
+                Type = "LoopStatement",
+                Condition = AstOp(AstId("i"), "<", AstInt(3)),
+                Body =
+                [
+                    AstVar("square", "Int", AstOp(AstId("i"), "*", AstId("i"))),
+                    AstPrint(AstId("square")),
+                    new Assignment
+                    {
+                        Type = "Assignment",
+                        Lhs = AstId("i"),
+                        Rhs = AstOp(AstId("i"), "+", AstInt(1)),
+                    },
+                ],
+            },
+            new ConditionalStatement
+            {
+                Type = "ConditionalStatement",
+                Condition = AstOp(AstId("i"), "==", AstInt(3)),
+                TrueBlock = [AstVar("done", "Int", AstId("i")), AstPrint(AstId("done"))],
+            },
+        ];
+
+        IrPrinter
+            .Print(new Optimizer().Optimize(new TypeChecker([]).CheckTypes(program)))
+            .Should()
+            .Be(
+                """
+                var i: Int = 0
+                while (i < 3) {
+                    var square: Int = (i * i)
+                    print(`${square}`)
+                    i = (i + 1)
+                }
+                if (i == 3) {
+                    var done: Int = i
+                    print(`${done}`)
+                }
+
+                """
+            );
+    }
+
+    private static TypeCheckedIdentifier Id(string name, Models.Type type) =>
+        new() { Name = name, Type = type };
+
+    private static TypedIntegerLiteral Int(long value) =>
+        new() { Type = BuiltIns.Int, Value = value };
+
+    private static TypeCheckedStringLiteral Str(string value) => new() { Value = value };
+
+    private static TypeCheckedCharLiteral Char(char value) => new() { Value = (byte)value };
+
+    private static TypeCheckedBooleanLiteral Bool(bool value) => new() { Value = value };
+
+    private static TypeCheckedStringInterpolation Interpolate(
+        params TypeCheckedExpression[] pieces
+    ) => new() { Pieces = pieces };
+
+    private static TypeCheckedIndexAccess Index(
+        TypeCheckedExpression receiver,
+        TypeCheckedExpression index
+    ) => new() { Base = receiver, Index = index };
+
+    private static TypeCheckedOperatorCall Op(
+        TypeCheckedExpression lhs,
+        string name,
+        TypeCheckedExpression rhs
+    ) =>
+        new()
+        {
+            Operator = BuiltIns.Operators.Single(o =>
+                o.Name == name
+                && o.Fixity == OperatorFixity.Infix
+                && o.LhsType == lhs.Type
+                && o.RhsType == rhs.Type
+            ),
+            Lhs = lhs,
+            Rhs = rhs,
+        };
+
+    private static TypeCheckedMethodCall Call(
+        TypeCheckedExpression receiver,
+        string name,
+        params TypeCheckedExpression[] arguments
+    ) =>
+        new()
+        {
+            Base = receiver,
+            Method = receiver.Type.Methods.First(m =>
+                m.Name == name && m.ArgumentTypes.Length == arguments.Length
+            ),
+            Arguments = arguments,
+        };
+
+    private static TypeCheckedFunctionCall Print(TypeCheckedExpression value) =>
+        new() { Method = BuiltIns.Methods.Single(m => m.Name == "print"), Arguments = [value] };
+
+    private static TypeCheckedVar Var(TypeCheckedIdentifier name, TypeCheckedExpression value) =>
+        new()
+        {
+            Name = name.Name,
+            Type = name.Type,
+            Value = value,
+        };
+
+    private static TypeCheckedAssignment Assign(
+        TypeCheckedExpression lhs,
+        TypeCheckedExpression rhs
+    ) => new() { Lhs = lhs, Rhs = rhs };
+
+    private static TypeCheckedConditional If(
+        TypeCheckedExpression condition,
+        List<TypeCheckedStatement> trueBlock,
+        List<TypeCheckedStatement>? falseBlock = null
+    ) =>
+        new()
+        {
+            Condition = condition,
+            TrueBlock = trueBlock,
+            FalseBlock = falseBlock ?? [],
+        };
+
+    private static TypeCheckedLoop While(
+        TypeCheckedExpression condition,
+        List<TypeCheckedStatement> body
+    ) => new() { Condition = condition, Body = body };
+
+    private static IntegerLiteral AstInt(long value) =>
+        new() { Type = "IntegerLiteral", Value = value };
+
+    private static Identifier AstId(string name) => new() { Type = "Identifier", Name = name };
+
+    private static BinaryExpression AstOp(Expression lhs, string op, Expression rhs) =>
+        new()
+        {
+            Type = "BinaryExpression",
+            Lhs = lhs,
+            Operator = op,
+            Rhs = rhs,
+        };
+
+    private static FunctionCall AstPrint(Expression value) =>
+        new()
+        {
+            Type = "FunctionCall",
+            Function = "print",
+            Arguments =
+            [
+                new StringInterpolation { Type = "StringInterpolation", Pieces = [value] },
+            ],
+        };
+
+    private static VarDeclaration AstVar(string name, string type, Expression value) =>
+        new()
+        {
+            Type = "VarDeclaration",
+            Name = name,
+            DeclaredType = new() { Name = type, Arguments = [] },
+            Value = value,
+        };
+}
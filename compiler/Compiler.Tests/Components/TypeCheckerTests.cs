@@ -0,0 +1,122 @@
+using Compiler.Components;
+using Compiler.Models;
+using FluentAssertions;
+
+namespace Compiler.Tests;
+
+public class TypeCheckerTests
+{
+    [Fact]
+    public void TypeChecker_ResolvesOverloadsThatDifferOnlyByArgumentType()
+    {
+        List<AstNode> program =
+        [
+            Function("describe", "Int"),
+            Function("describe", "String"),
+            new FunctionCall
+            {
+                Type = "FunctionCall",
+                Function = "describe",
+                Arguments = [new StringLiteral { Type = "StringLiteral", Value = "hi" }],
+            },
+        ];
+
+        var call = new TypeChecker([])
+            .CheckTypes(program)
+            .OfType<TypeCheckedFunctionCall>()
+            .Single();
+
+        call.Method.ArgumentTypes.Single().Should().Be(BuiltIns.String);
+    }
+
+    [Fact]
+    public void TypeChecker_RejectsCallsNoOverloadAccepts()
+    {
+        List<AstNode> program =
+        [
+            Function("describe", "Int"),
+            Function("describe", "String"),
+            new FunctionCall
+            {
+                Type = "FunctionCall",
+                Function = "describe",
+                Arguments = [new BooleanLiteral { Type = "BooleanLiteral", Value = true }],
+            },
+        ];
+
+        Action check = () => new TypeChecker([]).CheckTypes(program).ToList();
+
+        check.Should().Throw<TypeCheckException>();
+    }
+
+    [Fact]
+    public void TypeChecker_WritesWarningsToTheGivenWriter()
+    {
+        List<AstNode> program =
+        [
+            new ConditionalStatement
+            {
+                Type = "ConditionalStatement",
+                Condition = new BooleanLiteral { Type = "BooleanLiteral", Value = true },
+                TrueBlock = [],
+            },
+        ];
+        var warnings = new StringWriter();
+
+        new TypeChecker([], warnings).CheckTypes(program).ToList();
+
+        warnings.ToString().Should().Contain("Warning: empty if statement");
+    }
+
+    [Theory]
+    [InlineData("Int64")]
+    [InlineData("Int32")]
+    public void TypeChecker_RejectsOverloadsOnIntAndItsFixedWidthEquivalents(string sizedType)
+    {
+        // Int is the same C++ type as one of these, so the overloads' C++ would clash.
+        List<AstNode> program = [Function("describe", "Int"), Function("describe", sizedType)];
+
+        Action check = () => new TypeChecker([]).CheckTypes(program).ToList();
+
+        check.Should().Throw<TypeCheckException>().WithMessage("Possible duplicate declaration*");
+    }
+
+    [Fact]
+    public void TypeChecker_CallsFunctionsImportedFromAnotherModule()
+    {
+        var exports = new TypeChecker([]).DeclareFunctions(
+            [Function("describe", "String")],
+            isMain: false
+        );
+        var checker = new TypeChecker([]);
+        checker.Import(exports, "other.falafel");
+
+        var call = checker
+            .CheckTypes(
+                [
+                    new FunctionCall
+                    {
+                        Type = "FunctionCall",
+                        Function = "describe",
+                        Arguments = [new StringLiteral { Type = "StringLiteral", Value = "hi" }],
+                    },
+                ]
+            )
+            .OfType<TypeCheckedFunctionCall>()
+            .Single();
+
+        call.Method.Should().BeSameAs(exports.Single());
+    }
+
+    private static FunctionDeclaration Function(string name, string argumentType) =>
+        new()
+        {
+            Type = "FunctionDeclaration",
+            Name = name,
+            Arguments =
+            [
+                new() { Name = "value", Type = new() { Name = argumentType, Arguments = [] } },
+            ],
+            Body = [],
+        };
+}
@@ -0,0 +1,47 @@
+using Compiler.Models;
+using FluentAssertions;
+
+namespace Compiler.Tests;
+
+public class ScopeTests
+{
+    private static Scope<string, string> NewScope(params string[] values) =>
+        new(s => s.Split(':')[0], values);
+
+    [Fact]
+    public void Scope_Lookup_ReturnsOuterSymbolsFirst()
+    {
+        var outer = NewScope("f:1", "g:1", "f:2");
+        var inner = outer.Nested();
+        inner.Add("f:3");
+
+        inner.Lookup("f").Should().Equal("f:1", "f:2", "f:3");
+        inner.Lookup("g").Should().Equal("g:1");
+        inner.Lookup("h").Should().BeEmpty();
+    }
+
+    [Fact]
+    public void Scope_Find_PrefersInnermostSymbol()
+    {
+        var outer = NewScope("x:outer", "y:outer");
+        var inner = outer.Nested();
+        inner.Add("x:inner");
+
+        inner.Find("x").Should().Be("x:inner");
+        inner.Find("y").Should().Be("y:outer");
+        inner.Find("z").Should().BeNull();
+        outer.Find("x").Should().Be("x:outer");
+    }
+
+    [Fact]
+    public void Scope_Nested_DoesNotAddToParent()
+    {
+        var outer = NewScope("x:outer");
+        var inner = outer.Nested();
+        inner.Add("y:inner");
+
+        inner.DeclaresLocally("y").Should().BeTrue();
+        inner.DeclaresLocally("x").Should().BeFalse();
+        outer.Lookup("y").Should().BeEmpty();
+    }
+}
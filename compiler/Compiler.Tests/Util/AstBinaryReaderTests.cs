@@ -0,0 +1,29 @@
+using Compiler.Models;
+using Compiler.Util;
+using FluentAssertions;
+
+namespace Compiler.Tests;
+
+public class AstBinaryReaderTests
+{
+    [Fact]
+    public void AstBinaryReader_ReadsIntegerLiteralsAtTheEndsOfTheRange()
+    {
+        // What parser/src/binary.js writes for a file "a" holding the literals -2^63 and 2^63 - 1.
+        var data = Convert.FromHexString(
+            "464c41535402" // magic
+                + "010161" // strings: "a"
+                + "01000002" // one file, "a", with no lines and two nodes
+                + "0900ffffffffffffffffff01"
+                + "0900feffffffffffffffff01"
+        );
+
+        var literals = new AstBinaryReader(data)
+            .Read()["a"]
+            .Ast.Cast<IntegerLiteral>()
+            .Select(l => l.Value)
+            .ToList();
+
+        literals.Should().Equal(long.MinValue, long.MaxValue);
+    }
+}
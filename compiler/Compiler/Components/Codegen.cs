@@ -1,6 +1,7 @@
 using System.Collections.Frozen;
 using System.Globalization;
 using System.Text;
+using Compiler.Components.Passes;
 using Compiler.Models;
 using Compiler.Util;
 using Microsoft.Win32.SafeHandles;
@@ -9,7 +10,6 @@ namespace Compiler.Components;
 
 public class Codegen
 {
-    private const int MaxShortStringLength = 7;
     private static readonly NumberFormatInfo NumberFormatter = new();
     private static readonly IReadOnlyDictionary<char, string> SpecialEscapeSequences =
         new Dictionary<char, string>
@@ -25,6 +25,36 @@ public class Codegen
             { '\x7f', @"\177" },
         }.ToFrozenDictionary();
 
+    // Signedness and width in bytes, since the first letter would clash with Int's 'i'
+    private static readonly IReadOnlyDictionary<Models.Type, string> SizedIntegerManglings =
+        new Dictionary<Models.Type, string>
+        {
+            { BuiltIns.Int8, "n1" },
+            { BuiltIns.Int16, "n2" },
+            { BuiltIns.Int32, "n4" },
+            { BuiltIns.Int64, "n8" },
+            { BuiltIns.UInt8, "u1" },
+            { BuiltIns.UInt16, "u2" },
+            { BuiltIns.UInt32, "u4" },
+            { BuiltIns.UInt64, "u8" },
+        }.ToFrozenDictionary();
+
+    // The unsigned type that arithmetic on each sized integer is done in, which is at least as wide
+    // as int so that its operands aren't promoted to a signed type. Unsigned arithmetic wraps, and
+    // since C++20 converting the result back to a signed type wraps too.
+    private static readonly IReadOnlyDictionary<Models.Type, string> WrappingArithmeticTypes =
+        new Dictionary<Models.Type, string>
+        {
+            { BuiltIns.Int8, "unsigned" },
+            { BuiltIns.Int16, "unsigned" },
+            { BuiltIns.Int32, "UInt32" },
+            { BuiltIns.Int64, "UInt64" },
+            { BuiltIns.UInt8, "unsigned" },
+            { BuiltIns.UInt16, "unsigned" },
+            { BuiltIns.UInt32, "UInt32" },
+            { BuiltIns.UInt64, "UInt64" },
+        }.ToFrozenDictionary();
+
     static Codegen()
     {
         NumberFormatter.NaNSymbol = "NAN";
@@ -35,57 +65,104 @@ public class Codegen
 
     private static readonly byte[] Preamble = Encoding.UTF8.GetBytes("#include <falafel.hh>\n");
     private static readonly byte[] MainEntry = Encoding.UTF8.GetBytes(
-        "int main(int argc, const char** argv) {{"
+        "int main(int argc, const char** argv) {falafel_internal::set_arguments(argc, argv);{"
     );
+    // Tasks that were started but never awaited still get to finish before the program exits.
     private static readonly byte[] MainExit = Encoding.UTF8.GetBytes(
-        "}Object::collect_cycles();return 0;}"
+        "}falafel_internal::run_event_loop();Object::collect_cycles();return 0;}"
     );
 
+    // The source file, escaped for the `#line` directives, or null to leave them out.
+    private readonly string? _sourceFile;
     private readonly Dictionary<string, uint> _stringLiterals = [];
-    private string _beforeMainDecls = "";
+    private readonly StringBuilder _beforeMainDecls = new();
     private readonly StringBuilder _mainStatements = new();
-    private string _afterMainDecls = "";
+    private readonly StringBuilder _afterMainDecls = new();
     private uint _stringCount = 0;
+    private TemporaryNames _names = new([]);
+    private bool _inAsyncFunction = false;
     private StringBuilder _currentBlock;
 
-    public Codegen()
+    // User-defined functions called and declared here. Those declared in other modules need
+    // prototypes of their own.
+    private readonly HashSet<Method> _calledFunctions = [];
+    private readonly HashSet<Method> _declaredFunctions = [];
+
+    // Functions declared at the top level, which other modules may call. The rest are only called
+    // from this translation unit, and are given internal linkage so that those in different
+    // modules can share a mangled name.
+    private HashSet<Method> _exportedFunctions = [];
+
+    // Each statement is put on a line of its own, after a `#line` directive giving its line in
+    // `sourceFile`, so that the debug info read by debuggers, sanitizers and perf points at the
+    // falafel source. What the compiler adds around the statements counts towards the one before.
+    public Codegen(string? sourceFile = null)
     {
+        _sourceFile = sourceFile is null ? null : EscapeLiteralUtf8(sourceFile);
         _currentBlock = _mainStatements;
     }
 
-    public void GenerateCode(IEnumerable<TypeCheckedStatement> program, string? location)
+    // Modules other than the main one only hold functions, so their translation units have no
+    // `main`.
+    public void GenerateCode(
+        IEnumerable<TypeCheckedStatement> program,
+        string? location,
+        bool isMain = true
+    )
     {
+        _names = new TemporaryNames(program);
+        _exportedFunctions = program
+            .OfType<TypeCheckedFunctionDeclaration>()
+            .Select(fd => fd.Method)
+            .ToHashSet();
         GenerateCodeWithoutWriting(program);
 
-        foreach (var (str, index) in _stringLiterals)
+        var prototypes = _calledFunctions
+            .Except(_declaredFunctions)
+            .Select(m => FunctionSignature(m, m.Declaration!.Arguments.Select(a => a.Name)) + ";")
+            .Order(StringComparer.Ordinal);
+        _beforeMainDecls.Insert(0, string.Concat(prototypes));
+
+        if (_stringLiterals.Count > 0)
         {
-            string strAllocation;
+            // All literals share one array so that the program registers a single (no-op)
+            // destructor at startup, rather than one per literal.
+            var storage = new StringBuilder(
+                "static constinit ImmortalStorage<String> stringLiterals[] = {"
+            );
+            var pointers = new StringBuilder();
+            var position = 0;
 
-            var utf8Length = Encoding.UTF8.GetByteCount(str);
-            var escaped = EscapeLiteralUtf8(str);
-            if (utf8Length < MaxShortStringLength)
+            foreach (var (str, index) in _stringLiterals)
             {
-                strAllocation = $"String::allocate_small_utf8(u8\"{escaped}\")";
-            }
-            else
-            {
-                strAllocation = $"String::allocate_immortal_utf8(u8\"{escaped}\")";
+                storage.Append($"u8\"{EscapeLiteralUtf8(str)}\",");
+                pointers.Append(
+                    $"String* const {LiteralName(index)} = &stringLiterals[{position}].value;"
+                );
+                ++position;
             }
 
-            _beforeMainDecls = $"auto {LiteralName(index)} = {strAllocation};{_beforeMainDecls}";
+            storage.Append("};");
+            _beforeMainDecls.Insert(0, $"{storage}{pointers}");
         }
 
         using Stream stream = location is null
             ? Console.OpenStandardOutput()
             : new FileStream(location, FileMode.Create);
 
-        EmitCode(stream);
+        EmitCode(stream, isMain);
     }
 
     private void GenerateCodeWithoutWriting(IEnumerable<TypeCheckedStatement> program)
     {
         foreach (var node in program)
         {
+            // A function's body is written elsewhere, and marked there.
+            if (node is not TypeCheckedFunctionDeclaration)
+            {
+                _currentBlock.Append(LineDirective(node.Line));
+            }
+
             if (node is TypeCheckedClass)
             {
                 throw new NotImplementedException();
@@ -162,6 +239,45 @@ public class Codegen
                 oldBlock.Append(newBlock);
                 oldBlock.Append("}");
             }
+            else if (node is TypeCheckedForLoop f)
+            {
+                var oldBlock = _currentBlock;
+                var newBlock = new StringBuilder();
+                var variableType = RcPointerWrap(f.VariableType);
+
+                if (f is TypeCheckedRangeLoop r)
+                {
+                    // The bounds are read once, and the variable is a copy of a hidden counter so
+                    // the body can't change how many times the loop runs.
+                    var start = TranslateExpression(r.Start);
+                    var end = TranslateExpression(r.End);
+                    var counter = _names.Next("loop");
+                    var counterEnd = _names.Next("loopEnd");
+
+                    oldBlock.Append(
+                        $"for ({variableType} {counter} = {start}, {counterEnd} = {end}; "
+                            + $"{counter} < {counterEnd}; ++{counter}) {{"
+                    );
+                    newBlock.Append($"{variableType} {f.Variable} = {counter};");
+                }
+                else
+                {
+                    // Iterating over a copy keeps the buffer alive and unchanged, so the loop
+                    // walks a plain pointer range without bounds checks.
+                    var array = TranslateExpression(((TypeCheckedArrayLoop)f).Array);
+                    var arrayType = RcPointerWrap(((TypeCheckedArrayLoop)f).Array.Type);
+
+                    oldBlock.Append($"for ({variableType} {f.Variable} : {arrayType}({array})) {{");
+                }
+
+                _currentBlock = newBlock;
+
+                GenerateCodeWithoutWriting(f.Body);
+
+                _currentBlock = oldBlock;
+                oldBlock.Append(newBlock);
+                oldBlock.Append("}");
+            }
             else if (node is TypeCheckedExpression expr)
             {
                 var statement = TranslateExpression(expr) + ";";
@@ -170,28 +286,36 @@ public class Codegen
             else if (node is TypeCheckedReturnStatement rs)
             {
                 var value = rs.Value is null ? "" : TranslateExpression(rs.Value);
-                _currentBlock.Append($"return {value};");
+                var keyword = _inAsyncFunction ? "co_return" : "return";
+                _currentBlock.Append($"{keyword} {value};");
             }
             else if (node is TypeCheckedFunctionDeclaration fd)
             {
+                var linkage = _exportedFunctions.Contains(fd.Method) ? "" : "static ";
                 var functionSignature =
-                    $@"{
-                        RcPointerWrap(fd.Method.ReturnType)
-                    } {
-                        MangleMethodName(fd.Method)
-                    }({
-                        string.Join(", ", fd.Arguments.Select(a => $"{RcPointerWrap(a.Type)} {a.Name}"))
-                    })";
+                    linkage + FunctionSignature(fd.Method, fd.Arguments.Select(a => a.Name));
 
-                _beforeMainDecls += functionSignature + ";";
+                _declaredFunctions.Add(fd.Method);
+                _beforeMainDecls.Append(functionSignature).Append(';');
 
                 var oldBlock = _currentBlock;
+                var wasInAsyncFunction = _inAsyncFunction;
                 _currentBlock = new StringBuilder();
+                _inAsyncFunction = fd.IsAsync;
 
                 GenerateCodeWithoutWriting(fd.Body);
 
-                _afterMainDecls += $"{functionSignature}{{ {_currentBlock.ToString()} }}";
+                // An async function is a C++ coroutine, which it only is if it uses co_return or
+                // co_await somewhere, so one that returns Void ends in a co_return to make sure.
+                if (fd.IsAsync && fd.Method.ReturnType.GenericTypes.Single() == BuiltIns.Void)
+                {
+                    _currentBlock.Append("co_return;");
+                }
+
+                _afterMainDecls.Append(LineDirective(fd.Line));
+                _afterMainDecls.Append($"{functionSignature}{{ {_currentBlock.ToString()} }}");
                 _currentBlock = oldBlock;
+                _inAsyncFunction = wasInAsyncFunction;
             }
             else
             {
@@ -218,6 +342,10 @@ public class Codegen
             }
             else
             {
+                if (fc.Method.Declaration is not null)
+                {
+                    _calledFunctions.Add(fc.Method);
+                }
                 return $"{MangleMethodName(fc.Method)}({argumentsString})";
             }
         }
@@ -234,7 +362,7 @@ public class Codegen
             }
             else
             {
-                return "(Int)" + valueString;
+                return $"({il.Type.Name}){valueString}";
             }
         }
         else if (expr is TypedDecimalLiteral dl)
@@ -301,6 +429,24 @@ public class Codegen
                     rhsString = $" ({TranslateExpression(o.Rhs)})";
                 }
 
+                // Addition, subtraction, multiplication and negation of sized integers wrap around,
+                // so they're done in an unsigned type. Division can't overflow except by dividing
+                // the smallest value by -1, which is left undefined as it is for Int. Either way,
+                // operands narrower than int are promoted, so the result is converted back.
+                if (
+                    WrappingArithmeticTypes.TryGetValue(o.Operator.ReturnType, out var wrappingType)
+                )
+                {
+                    var typeName = o.Operator.ReturnType.Name;
+                    if (o.Operator.Name is "+" or "-" or "*")
+                    {
+                        lhsString =
+                            o.Lhs is null ? "0U" : $"static_cast<{wrappingType}>({lhsString})";
+                        rhsString = $"static_cast<{wrappingType}>({rhsString})";
+                    }
+                    return $"static_cast<{typeName}>({lhsString}{o.Operator.CppName}{rhsString})";
+                }
+
                 return lhsString + o.Operator.CppName + rhsString;
             }
             else
@@ -325,7 +471,8 @@ public class Codegen
             var sbNum = _stringCount;
             ++_stringCount;
 
-            _currentBlock.Append($"StringBuilder sb{sbNum}({si.Pieces.Count()}U);");
+            var estimate = si.Pieces.Sum(EstimateFormattedLength);
+            _currentBlock.Append($"StringBuilder sb{sbNum}({estimate}U);");
             foreach (var piece in si.Pieces)
             {
                 var statement = $"sb{sbNum}.add_piece({TranslateExpression(piece)});";
@@ -350,7 +497,7 @@ public class Codegen
             var typeString = RcPointerWrap(cast.Type);
             if (cast.Base.Type.IsStrictSuperclassOf(cast.Type))
             {
-                // Call the `explicit` constructor on RcPointer, which calls dynamic_cast
+                // Call the `explicit` constructor on RcPointer, which checks the class IDs
                 return $"{typeString}{{ {inner} }}";
             }
             return $"static_cast<{typeString} >({inner})";
@@ -377,6 +524,20 @@ public class Codegen
                 string.Join(", ", mc.Arguments.Select(TranslateExpression))
             })";
         }
+        else if (expr is TypeCheckedAwait aw)
+        {
+            // Outside an async function there's nothing to suspend, so the event loop runs right
+            // here until the task is done.
+            var operand = TranslateExpression(aw.Operand);
+            return _inAsyncFunction
+                ? $"(co_await {operand})"
+                : $"falafel_internal::run_until_complete({operand})";
+        }
+        else if (expr is TypeCheckedFunctionReference fr)
+        {
+            _calledFunctions.Add(fr.Method);
+            return MangleMethodName(fr.Method);
+        }
         else if (expr is TypeCheckedCharLiteral cl)
         {
             return $@"u8'\x{cl.Value:x2}'";
@@ -391,27 +552,30 @@ public class Codegen
         }
     }
 
-    private void EmitCode(Stream stream)
+    private void EmitCode(Stream stream, bool isMain)
     {
         stream.Write(Preamble, 0, Preamble.Length);
 
-        var beforeMainBytes = Encoding.UTF8.GetBytes(_beforeMainDecls);
+        var beforeMainBytes = Encoding.UTF8.GetBytes(_beforeMainDecls.ToString());
         if (beforeMainBytes.Length > 0)
         {
             stream.Write(beforeMainBytes, 0, beforeMainBytes.Length);
         }
 
-        stream.Write(MainEntry, 0, MainEntry.Length);
-
-        var mainBytes = Encoding.UTF8.GetBytes(_mainStatements.ToString());
-        if (mainBytes.Length > 0)
+        if (isMain)
         {
-            stream.Write(mainBytes, 0, mainBytes.Length);
-        }
+            stream.Write(MainEntry, 0, MainEntry.Length);
+
+            var mainBytes = Encoding.UTF8.GetBytes(_mainStatements.ToString());
+            if (mainBytes.Length > 0)
+            {
+                stream.Write(mainBytes, 0, mainBytes.Length);
+            }
 
-        stream.Write(MainExit, 0, MainExit.Length);
+            stream.Write(MainExit, 0, MainExit.Length);
+        }
 
-        var afterMainBytes = Encoding.UTF8.GetBytes(_afterMainDecls);
+        var afterMainBytes = Encoding.UTF8.GetBytes(_afterMainDecls.ToString());
         if (afterMainBytes.Length > 0)
         {
             stream.Write(afterMainBytes, 0, afterMainBytes.Length);
@@ -420,8 +584,40 @@ public class Codegen
         stream.WriteByte(10);
     }
 
+    // Guesses how many bytes a piece of an interpolated string takes up, so the StringBuilder can
+    // usually allocate its buffer once. Numbers assume typical magnitudes rather than the worst case.
+    private static int EstimateFormattedLength(TypeCheckedExpression piece)
+    {
+        if (piece is TypeCheckedStringLiteral sl)
+        {
+            return Encoding.UTF8.GetByteCount(sl.Value);
+        }
+
+        var type = piece.Type;
+        if (type == BuiltIns.Char)
+        {
+            return 1;
+        }
+        if (type == BuiltIns.Bool)
+        {
+            return 5;
+        }
+        if (BuiltIns.IntegerTypes.Contains(type))
+        {
+            return 11;
+        }
+        if (type == BuiltIns.Float || type == BuiltIns.Double)
+        {
+            return 18;
+        }
+        return 16;
+    }
+
     private static string LiteralName(uint index) => $"stringLiteral{index:X}";
 
+    private string LineDirective(int? line) =>
+        _sourceFile is null || line is null ? "" : $"\n#line {line} \"{_sourceFile}\"\n";
+
     private static string EscapeLiteralUtf8(string s)
     {
         var builder = new StringBuilder(s.Length);
@@ -451,6 +647,15 @@ public class Codegen
     private const ulong StructEncoding = 0b10UL;
     private const ulong GenericTypeEncoding = 0b11UL;
 
+    private static string FunctionSignature(Method m, IEnumerable<string> argumentNames) =>
+        $@"{
+            RcPointerWrap(m.ReturnType)
+        } {
+            MangleMethodName(m)
+        }({
+            string.Join(", ", m.ArgumentTypes.Zip(argumentNames, (t, n) => $"{RcPointerWrap(t)} {n}"))
+        })";
+
     private static string MangleMethodName(Method m)
     {
         ulong argumentEncoding = 1UL;
@@ -485,6 +690,10 @@ public class Codegen
         {
             return "t";
         }
+        if (SizedIntegerManglings.TryGetValue(t, out var mangling))
+        {
+            return mangling;
+        }
         if (BuiltIns.PrimitiveTypes.Contains(t))
         {
             return char.ToLowerInvariant(t.Name[0]).ToString();
@@ -0,0 +1,115 @@
+using System.Runtime.ExceptionServices;
+using Compiler.Models;
+using Compiler.Util;
+
+namespace Compiler.Components;
+
+// Compiles several source files together, each to its own C++ translation unit so that the C++
+// compiler can build them separately and in parallel. The first file is the main module, whose
+// top-level statements make up the program. The others may only declare functions, and every
+// module can call the functions declared at the top level of every other one.
+//
+// Each module is checked against the signatures of the other modules' functions, never their
+// bodies, and its C++ only declares the functions it calls. So its C++ stays the same, and the
+// object file built from it can be reused, unless it or one of those signatures changes.
+//
+// Warnings are written to `warnings`, which the modules share as they are checked in parallel.
+public class ModuleCompiler(
+    Dictionary<string, AstRoot> modules,
+    PassTimer? timer = null,
+    TextWriter? warnings = null
+)
+{
+    private readonly TextWriter _warnings = TextWriter.Synchronized(warnings ?? Console.Error);
+
+    public static string FileName(int index) => $"module{index}.cpp";
+
+    public void Compile(string directory)
+    {
+        var files = modules.ToArray();
+        var checkers = files.Select(f => new TypeChecker(f.Value.LineCounts, _warnings)).ToArray();
+        var exports = new IReadOnlyList<Method>[files.Length];
+
+        // Each module's phases are timed in a lane of their own, after the main thread's.
+        ForEachModule(
+            files,
+            i =>
+            {
+                using (timer?.Phase($"declare functions: {files[i].Key}", i + 1))
+                {
+                    exports[i] = checkers[i].DeclareFunctions(files[i].Value.Ast, isMain: i == 0);
+                }
+            }
+        );
+
+        Directory.CreateDirectory(directory);
+
+        ForEachModule(
+            files,
+            i =>
+            {
+                for (var j = 0; j < files.Length; ++j)
+                {
+                    if (j != i)
+                    {
+                        checkers[i].Import(exports[j], files[j].Key);
+                    }
+                }
+
+                List<TypeCheckedStatement> typeCheckedStatements;
+                using (timer?.Phase($"type check: {files[i].Key}", i + 1))
+                {
+                    typeCheckedStatements = checkers[i].CheckTypes(files[i].Value.Ast).ToList();
+                }
+
+                var optimizedStatements = new Optimizer(timer, i + 1).Optimize(
+                    typeCheckedStatements
+                );
+
+                using (timer?.Phase($"codegen: {files[i].Key}", i + 1))
+                {
+                    new Codegen(files[i].Key).GenerateCode(
+                        optimizedStatements,
+                        Path.Combine(directory, FileName(i)),
+                        isMain: i == 0
+                    );
+                }
+            }
+        );
+    }
+
+    // Runs `action` on every module at once. If any of them fail, the error from the first one is
+    // rethrown, so that the same error is reported every time.
+    private static void ForEachModule(KeyValuePair<string, AstRoot>[] files, Action<int> action)
+    {
+        var errors = new Exception?[files.Length];
+
+        Parallel.For(
+            0,
+            files.Length,
+            i =>
+            {
+                try
+                {
+                    action(i);
+                }
+                catch (Exception e)
+                {
+                    errors[i] = e;
+                }
+            }
+        );
+
+        for (var i = 0; i < files.Length; ++i)
+        {
+            if (errors[i] is TypeCheckException tce)
+            {
+                throw new TypeCheckException($"{files[i].Key}: {tce.Message}", tce);
+            }
+            if (errors[i] is Exception e)
+            {
+                ExceptionDispatchInfo.Throw(e);
+            }
+        }
+    }
+}
@@ -0,0 +1,35 @@
+using Compiler.Components.Passes;
+using Compiler.Models;
+using Compiler.Util;
+
+namespace Compiler.Components;
+
+// Runs the optimization passes over the type-checked program before it is handed to Codegen. Each
+// pass takes a tree and returns a new one with the same meaning; see Components/Passes.
+public class Optimizer(PassTimer? timer = null, int lane = 0)
+{
+    public List<TypeCheckedStatement> Optimize(IEnumerable<TypeCheckedStatement> program)
+    {
+        // Type checking happens lazily, so this is where any type errors are thrown.
+        var statements = program.ToList();
+        var names = new TemporaryNames(statements);
+
+        IEnumerable<TreeRewriter> passes =
+        [
+            new ConstantFolding(),
+            new DeadCodeElimination(),
+            new LoopInvariantHoisting(names),
+            new CommonSubexpressionElimination(names),
+        ];
+
+        foreach (var pass in passes)
+        {
+            using (timer?.Phase(pass.GetType().Name, lane))
+            {
+                statements = pass.Run(statements);
+            }
+        }
+
+        return statements;
+    }
+}
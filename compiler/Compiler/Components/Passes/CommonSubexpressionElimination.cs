@@ -0,0 +1,229 @@
+using Compiler.Models;
+using Compiler.Util;
+
+namespace Compiler.Components.Passes;
+
+// Computes repeated index accesses and method calls once, such as `program[i]` tested by each
+// branch of an `else if` chain. When a statement computes such an expression and it is needed
+// again before any variable it reads changes, its value is stored in a new variable right before
+// that statement, and later occurrences in the same block and in the blocks nested in it use the
+// variable instead.
+public class CommonSubexpressionElimination(TemporaryNames names) : TreeRewriter
+{
+    private record Available(TypeCheckedIdentifier Temporary, ISet<string> Reads);
+
+    // Expressions already stored in a variable, keyed by their printed form.
+    private Dictionary<string, Available> _available = [];
+
+    protected override List<TypeCheckedStatement> RewriteBlock(
+        IEnumerable<TypeCheckedStatement> block
+    )
+    {
+        var statements = block.ToList();
+        var outer = _available;
+        _available = new Dictionary<string, Available>(outer);
+        var result = new List<TypeCheckedStatement>();
+
+        for (var k = 0; k < statements.Count; ++k)
+        {
+            var statement = statements[k];
+            var canMoveFailures = !HasEarlierSideEffects(statement);
+
+            foreach (var candidate in Candidates(statement))
+            {
+                var key = IrPrinter.PrintExpression(candidate);
+                if (
+                    _available.ContainsKey(key)
+                    || (!canMoveFailures && !Effects.IsPure(candidate))
+                    || CountUses(key, candidate, statements, k) < 2
+                )
+                {
+                    continue;
+                }
+
+                var temporary = new TypeCheckedIdentifier
+                {
+                    Name = names.Next("cse"),
+                    Type = candidate.Type,
+                };
+                result.Add(
+                    new TypeCheckedVar
+                    {
+                        Name = temporary.Name,
+                        Type = temporary.Type,
+                        Value = RewriteExpressionChildren(candidate),
+                        Line = statement.Line,
+                    }
+                );
+                _available[key] = new Available(temporary, Effects.ReadVariables(candidate));
+            }
+
+            result.AddRange(RewriteStatement(statement));
+            Invalidate(Effects.WrittenVariables([statement]));
+        }
+
+        _available = outer;
+        return result;
+    }
+
+    protected override IEnumerable<TypeCheckedStatement> RewriteStatement(
+        TypeCheckedStatement statement
+    )
+    {
+        if (statement is not (TypeCheckedLoop or TypeCheckedForLoop))
+        {
+            return base.RewriteStatement(statement);
+        }
+
+        // The condition and body run repeatedly, so they can only reuse what the loop never
+        // invalidates. That includes a `for` loop's variable, which may shadow an outer one.
+        var outer = _available;
+        _available = new Dictionary<string, Available>(outer);
+        Invalidate(Effects.WrittenVariables([statement]));
+        var result = RewriteChildren(statement);
+        _available = outer;
+        return [result];
+    }
+
+    protected override List<TypeCheckedStatement> RewriteFunctionBody(
+        TypeCheckedFunctionDeclaration fd
+    )
+    {
+        var outer = _available;
+        _available = [];
+        var result = RewriteBlock(fd.Body);
+        _available = outer;
+        return result;
+    }
+
+    protected override TypeCheckedExpression RewriteExpression(TypeCheckedExpression expr)
+    {
+        if (
+            IsCandidateKind(expr)
+            && _available.TryGetValue(IrPrinter.PrintExpression(expr), out var available)
+        )
+        {
+            return available.Temporary;
+        }
+        return RewriteExpressionChildren(expr);
+    }
+
+    private void Invalidate(ISet<string> written)
+    {
+        foreach (var (key, available) in _available)
+        {
+            if (available.Reads.Overlaps(written))
+            {
+                _available.Remove(key);
+            }
+        }
+    }
+
+    private static bool IsCandidateKind(TypeCheckedExpression expr) =>
+        expr is TypeCheckedIndexAccess
+        || (expr is TypeCheckedMethodCall mc && !Effects.IsMutating(mc.Method));
+
+    // Expressions `statement` always evaluates before anything else it does, innermost first.
+    private static IEnumerable<TypeCheckedExpression> Candidates(TypeCheckedStatement statement) =>
+        Evaluated(statement, includeLoops: false)
+            .SelectMany(e => Evaluated(e, includeConditional: false))
+            .Where(e =>
+                IsCandidateKind(e) && e.Type != BuiltIns.Void && Effects.IsSideEffectFree(e)
+            );
+
+    // The expressions a statement evaluates as values, not counting nested blocks. Places being
+    // assigned to or mutated only contribute their indices.
+    private static IEnumerable<TypeCheckedExpression> Evaluated(
+        TypeCheckedStatement statement,
+        bool includeLoops
+    ) =>
+        statement switch
+        {
+            TypeCheckedVar v => [v.Value],
+            TypeCheckedAssignment a => TargetIndices(a.Lhs).Append(a.Rhs),
+            TypeCheckedConditional c => [c.Condition],
+            TypeCheckedLoop l when includeLoops => [l.Condition],
+            TypeCheckedRangeLoop r when includeLoops => [r.Start, r.End],
+            TypeCheckedArrayLoop a when includeLoops => [a.Array],
+            TypeCheckedReturnStatement { Value: not null } rs => [rs.Value],
+            TypeCheckedExpression e => [e],
+            _ => [],
+        };
+
+    // `expr` and the values computed within it, innermost first. Unless `includeConditional` is
+    // set, right-hand sides of short-circuiting operators are left out, since they may not run.
+    private static IEnumerable<TypeCheckedExpression> Evaluated(
+        TypeCheckedExpression expr,
+        bool includeConditional
+    )
+    {
+        IEnumerable<TypeCheckedExpression> children = expr switch
+        {
+            TypeCheckedOperatorCall o when !includeConditional && Effects.ShortCircuits(o) => [
+                o.Lhs!,
+            ],
+            TypeCheckedMethodCall mc when Effects.IsMutating(mc.Method) => mc.Arguments.Concat(
+                TargetIndices(mc.Base)
+            ),
+            _ => Effects.Children(expr),
+        };
+        foreach (var child in children)
+        {
+            foreach (var node in Evaluated(child, includeConditional))
+            {
+                yield return node;
+            }
+        }
+        yield return expr;
+    }
+
+    // The indices read while finding the place `target` refers to.
+    private static IEnumerable<TypeCheckedExpression> TargetIndices(TypeCheckedExpression target) =>
+        target switch
+        {
+            TypeCheckedIndexAccess ia => TargetIndices(ia.Base).Append(ia.Index),
+            TypeCheckedPropertyAccess pa => TargetIndices(pa.Base),
+            _ => [],
+        };
+
+    // Whether `statement` may do something observable before the expressions it evaluates first,
+    // in which case an expression that may fail can't be moved ahead of it. Arguments are always
+    // evaluated before the call they're passed to.
+    private static bool HasEarlierSideEffects(TypeCheckedStatement statement) =>
+        Effects
+            .TopLevelExpressions(statement)
+            .Any(e =>
+                e is TypeCheckedFunctionCall or TypeCheckedMethodCall
+                    ? !Effects.Children(e).All(Effects.IsSideEffectFree)
+                    : !Effects.IsSideEffectFree(e)
+            );
+
+    // How many times the expression printed as `key` is computed from `statements[k]` onward,
+    // until a statement changes one of the variables it reads.
+    private static int CountUses(
+        string key,
+        TypeCheckedExpression candidate,
+        List<TypeCheckedStatement> statements,
+        int k
+    )
+    {
+        var reads = Effects.ReadVariables(candidate);
+        var count = 0;
+
+        for (var j = k; j < statements.Count && count < 2; ++j)
+        {
+            count += Effects
+                .Statements([statements[j]])
+                .SelectMany(s => Evaluated(s, includeLoops: true))
+                .SelectMany(e => Evaluated(e, includeConditional: true))
+                .Count(e => IsCandidateKind(e) && IrPrinter.PrintExpression(e) == key);
+
+            if (Effects.WrittenVariables([statements[j]]).Overlaps(reads))
+            {
+                break;
+            }
+        }
+
+        return count;
+    }
+}
@@ -0,0 +1,372 @@
+using System.Globalization;
+using System.Text;
+using Compiler.Models;
+
+namespace Compiler.Components.Passes;
+
+// Evaluates operators, casts, and string interpolations whose operands are all literals, and
+// substitutes the value of variables that are initialized with a literal and never assigned to.
+// Folding only happens where the result is the same on every target: integer arithmetic that could
+// overflow, and formatting of floating-point numbers, are left to the program.
+public class ConstantFolding : TreeRewriter
+{
+    private Dictionary<string, TypeCheckedExpression> _constants = [];
+    private ISet<string> _assigned = new HashSet<string>();
+
+    public override List<TypeCheckedStatement> Run(IEnumerable<TypeCheckedStatement> program)
+    {
+        var statements = program.ToList();
+        _assigned = Effects.AssignedVariables(statements);
+        return RewriteBlock(statements);
+    }
+
+    protected override List<TypeCheckedStatement> RewriteBlock(
+        IEnumerable<TypeCheckedStatement> block
+    )
+    {
+        // A constant declared inside the block goes out of scope with it, and one shadowed inside
+        // the block comes back into scope after it.
+        var outer = _constants;
+        _constants = new Dictionary<string, TypeCheckedExpression>(outer);
+        var result = base.RewriteBlock(block);
+        _constants = outer;
+        return result;
+    }
+
+    protected override IEnumerable<TypeCheckedStatement> RewriteStatement(
+        TypeCheckedStatement statement
+    )
+    {
+        var rewritten = RewriteChildren(statement);
+        if (rewritten is TypeCheckedVar v)
+        {
+            if (
+                Effects.IsConstant(v.Value)
+                && v.Value.Type == v.Type
+                && !_assigned.Contains(v.Name)
+            )
+            {
+                _constants[v.Name] = v.Value;
+            }
+            else
+            {
+                _constants.Remove(v.Name);
+            }
+        }
+        return [rewritten];
+    }
+
+    protected override List<TypeCheckedStatement> RewriteFunctionBody(
+        TypeCheckedFunctionDeclaration fd
+    )
+    {
+        var (outerConstants, outerAssigned) = (_constants, _assigned);
+
+        // Arguments shadow any outer constants of the same name.
+        _constants = [];
+        _assigned = Effects.AssignedVariables(fd.Body);
+        var result = RewriteBlock(fd.Body);
+
+        (_constants, _assigned) = (outerConstants, outerAssigned);
+        return result;
+    }
+
+    protected override TypeCheckedExpression RewriteExpression(TypeCheckedExpression expr)
+    {
+        if (expr is TypeCheckedIdentifier i && _constants.TryGetValue(i.Name, out var value))
+        {
+            return value;
+        }
+
+        var rewritten = RewriteExpressionChildren(expr);
+        return rewritten switch
+        {
+            TypeCheckedOperatorCall o => FoldOperator(o),
+            TypeCheckedStringInterpolation si => FoldInterpolation(si),
+            TypeCheckedCastExpression cast => FoldCast(cast),
+            _ => rewritten,
+        };
+    }
+
+    private static TypeCheckedExpression FoldOperator(TypeCheckedOperatorCall o)
+    {
+        var name = o.Operator.Name;
+
+        if (o.Lhs is null && o.Rhs is not null)
+        {
+            return (name, o.Rhs) switch
+            {
+                ("!", TypeCheckedBooleanLiteral b) => Bool(!b.Value),
+                ("-", TypedIntegerLiteral i)
+                    when i.Type == BuiltIns.Int && IsPortableInt(-i.Value) => Integer(-i.Value),
+                ("-", _) when TryGetNumber(o.Rhs, out var d) && o.Rhs.Type == BuiltIns.Double =>
+                    Decimal(BuiltIns.Double, -d),
+                ("-", _) when TryGetNumber(o.Rhs, out var f) && o.Rhs.Type == BuiltIns.Float =>
+                    Decimal(BuiltIns.Float, -(float)f),
+                _ => o,
+            };
+        }
+
+        if (o.Lhs is null || o.Rhs is null)
+        {
+            return o;
+        }
+
+        // Short-circuiting operators only need their left-hand side.
+        if (o.Lhs is TypeCheckedBooleanLiteral lhsBool)
+        {
+            if (name == "&&")
+            {
+                return lhsBool.Value ? o.Rhs : lhsBool;
+            }
+            if (name == "||")
+            {
+                return lhsBool.Value ? lhsBool : o.Rhs;
+            }
+        }
+        if (name == "??" && o.Lhs is TypeCheckedNullLiteral)
+        {
+            return o.Rhs;
+        }
+
+        var type = o.Operator.LhsType;
+        if (
+            type == BuiltIns.Int
+            && o.Lhs is TypedIntegerLiteral l
+            && o.Rhs is TypedIntegerLiteral r
+        )
+        {
+            return FoldInt(o, l.Value, r.Value);
+        }
+        if (
+            (type == BuiltIns.Double || type == BuiltIns.Float)
+            && TryGetNumber(o.Lhs, out var ld)
+            && TryGetNumber(o.Rhs, out var rd)
+        )
+        {
+            return type == BuiltIns.Double
+                ? FoldDouble(o, ld, rd)
+                : FoldFloat(o, (float)ld, (float)rd);
+        }
+        if (o.Lhs is TypeCheckedCharLiteral lc && o.Rhs is TypeCheckedCharLiteral rc)
+        {
+            return Compare(o, lc.Value.CompareTo(rc.Value));
+        }
+        if (o.Lhs is TypeCheckedBooleanLiteral lb && o.Rhs is TypeCheckedBooleanLiteral rb)
+        {
+            return name switch
+            {
+                "==" => Bool(lb.Value == rb.Value),
+                "!=" => Bool(lb.Value != rb.Value),
+                _ => o,
+            };
+        }
+        if (o.Lhs is TypeCheckedStringLiteral ls && o.Rhs is TypeCheckedStringLiteral rs)
+        {
+            // Only equality, since ordering compares UTF-8 bytes rather than UTF-16 code units.
+            return name switch
+            {
+                "+" => new TypeCheckedStringLiteral { Value = ls.Value + rs.Value },
+                "==" => Bool(ls.Value == rs.Value),
+                "!=" => Bool(ls.Value != rs.Value),
+                _ => o,
+            };
+        }
+
+        return o;
+    }
+
+    private static TypeCheckedExpression FoldInt(TypeCheckedOperatorCall o, long l, long r)
+    {
+        long? result = o.Operator.Name switch
+        {
+            "+" => l + r,
+            "-" => l - r,
+            "*" => l * r,
+            // Both truncate toward zero, as in C++.
+            "/" when r != 0 => l / r,
+            "%" when r != 0 => l % r,
+            _ => null,
+        };
+
+        if (result is null)
+        {
+            return Compare(o, l.CompareTo(r));
+        }
+        return IsPortableInt(l) && IsPortableInt(r) && IsPortableInt(result.Value)
+            ? Integer(result.Value)
+            : o;
+    }
+
+    // Int is only guaranteed to have 32 bits, and signed overflow is undefined, so anything outside
+    // that range is left for the C++ compiler to deal with.
+    private static bool IsPortableInt(long value) => value is >= int.MinValue and <= int.MaxValue;
+
+    private static TypeCheckedExpression FoldDouble(
+        TypeCheckedOperatorCall o,
+        double l,
+        double r
+    ) =>
+        o.Operator.Name switch
+        {
+            "+" => Decimal(BuiltIns.Double, l + r),
+            "-" => Decimal(BuiltIns.Double, l - r),
+            "*" => Decimal(BuiltIns.Double, l * r),
+            "/" => Decimal(BuiltIns.Double, l / r),
+            "<" => Bool(l < r),
+            "<=" => Bool(l <= r),
+            ">" => Bool(l > r),
+            ">=" => Bool(l >= r),
+            "==" => Bool(l == r),
+            "!=" => Bool(l != r),
+            _ => o,
+        };
+
+    private static TypeCheckedExpression FoldFloat(TypeCheckedOperatorCall o, float l, float r) =>
+        o.Operator.Name switch
+        {
+            "+" => Decimal(BuiltIns.Float, l + r),
+            "-" => Decimal(BuiltIns.Float, l - r),
+            "*" => Decimal(BuiltIns.Float, l * r),
+            "/" => Decimal(BuiltIns.Float, l / r),
+            "<" => Bool(l < r),
+            "<=" => Bool(l <= r),
+            ">" => Bool(l > r),
+            ">=" => Bool(l >= r),
+            "==" => Bool(l == r),
+            "!=" => Bool(l != r),
+            _ => o,
+        };
+
+    // Folds a comparison operator given the three-way comparison of its operands.
+    private static TypeCheckedExpression Compare(TypeCheckedOperatorCall o, int comparison) =>
+        o.Operator.Name switch
+        {
+            "<" => Bool(comparison < 0),
+            "<=" => Bool(comparison <= 0),
+            ">" => Bool(comparison > 0),
+            ">=" => Bool(comparison >= 0),
+            "==" => Bool(comparison == 0),
+            "!=" => Bool(comparison != 0),
+            _ => o,
+        };
+
+    private static TypeCheckedExpression FoldCast(TypeCheckedCastExpression cast)
+    {
+        if (
+            cast.Base is TypedIntegerLiteral i
+            && i.Type == BuiltIns.Int
+            && Math.Abs(i.Value) <= 1L << 53
+        )
+        {
+            if (cast.Type == BuiltIns.Int)
+            {
+                return i;
+            }
+            if (cast.Type == BuiltIns.Double)
+            {
+                return Decimal(BuiltIns.Double, i.Value);
+            }
+            if (cast.Type == BuiltIns.Float)
+            {
+                return Decimal(BuiltIns.Float, (float)i.Value);
+            }
+        }
+        return cast;
+    }
+
+    // Merges runs of literal pieces (and the pieces of nested interpolations) into single string
+    // literals, leaving a plain string literal if nothing else remains.
+    private static TypeCheckedExpression FoldInterpolation(TypeCheckedStringInterpolation si)
+    {
+        var pieces = new List<TypeCheckedExpression>();
+        var pending = new StringBuilder();
+
+        void Add(TypeCheckedExpression piece)
+        {
+            if (TryFormat(piece, out var text))
+            {
+                pending.Append(text);
+            }
+            else if (piece is TypeCheckedStringInterpolation inner)
+            {
+                foreach (var innerPiece in inner.Pieces)
+                {
+                    Add(innerPiece);
+                }
+            }
+            else
+            {
+                if (pending.Length > 0)
+                {
+                    pieces.Add(new TypeCheckedStringLiteral { Value = pending.ToString() });
+                    pending.Clear();
+                }
+                pieces.Add(piece);
+            }
+        }
+
+        foreach (var piece in si.Pieces)
+        {
+            Add(piece);
+        }
+
+        if (pieces.Count == 0)
+        {
+            return new TypeCheckedStringLiteral { Value = pending.ToString() };
+        }
+        if (pending.Length > 0)
+        {
+            pieces.Add(new TypeCheckedStringLiteral { Value = pending.ToString() });
+        }
+        return new TypeCheckedStringInterpolation { Pieces = pieces };
+    }
+
+    // Formats a literal the way the runtime would. Floating-point numbers are left alone, since
+    // .NET and the runtime don't agree on the shortest round-tripping representation.
+    private static bool TryFormat(TypeCheckedExpression piece, out string text)
+    {
+        switch (piece)
+        {
+            case TypeCheckedStringLiteral sl:
+                text = sl.Value;
+                return true;
+            case TypedIntegerLiteral il when BuiltIns.IntegerTypes.Contains(il.Type):
+                text = il.Value.ToString(CultureInfo.InvariantCulture);
+                return true;
+            case TypeCheckedBooleanLiteral bl:
+                text = bl.Value ? "true" : "false";
+                return true;
+            case TypeCheckedCharLiteral { Value: < 0x80 } cl:
+                text = ((char)cl.Value).ToString();
+                return true;
+            default:
+                text = "";
+                return false;
+        }
+    }
+
+    private static bool TryGetNumber(TypeCheckedExpression expr, out double value)
+    {
+        switch (expr)
+        {
+            case TypedIntegerLiteral il when Math.Abs(il.Value) <= 1L << 53:
+                value = il.Value;
+                return true;
+            case TypedDecimalLiteral dl:
+                value = dl.Value;
+                return true;
+            default:
+                value = 0.0;
+                return false;
+        }
+    }
+
+    private static TypeCheckedBooleanLiteral Bool(bool value) => new() { Value = value };
+
+    private static TypedIntegerLiteral Integer(long value) =>
+        new() { Type = BuiltIns.Int, Value = value };
+
+    private static TypedDecimalLiteral Decimal(Models.Type type, double value) =>
+        new() { Type = type, Value = value };
+}
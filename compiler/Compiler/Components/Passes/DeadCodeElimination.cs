@@ -0,0 +1,189 @@
+using Compiler.Models;
+
+namespace Compiler.Components.Passes;
+
+// Removes code that can't run or whose results are never used:
+//  - branches of conditionals on a constant, and loops on `false`;
+//  - statements after a `return`;
+//  - expression statements with no side effects;
+//  - variables that are never read, along with assignments to them;
+//  - stores that are overwritten before the variable is read again.
+// Where a removed declaration or store computes something with side effects, that computation is
+// kept as an expression statement.
+public class DeadCodeElimination : TreeRewriter
+{
+    private ISet<string> _read = new HashSet<string>();
+
+    public override List<TypeCheckedStatement> Run(IEnumerable<TypeCheckedStatement> program)
+    {
+        var statements = program.ToList();
+
+        // Collected over the whole program, functions included, so that a name read anywhere is
+        // kept everywhere.
+        _read = AllStatements(statements)
+            .SelectMany(Effects.TopLevelExpressions)
+            .SelectMany(Effects.ReadVariables)
+            .ToHashSet();
+
+        return RewriteBlock(statements);
+    }
+
+    private static IEnumerable<TypeCheckedStatement> AllStatements(
+        IEnumerable<TypeCheckedStatement> statements
+    ) =>
+        Effects
+            .Statements(statements)
+            .SelectMany(s =>
+                s is TypeCheckedFunctionDeclaration fd ? AllStatements(fd.Body).Prepend(s) : [s]
+            );
+
+    protected override List<TypeCheckedStatement> RewriteBlock(
+        IEnumerable<TypeCheckedStatement> block
+    )
+    {
+        var result = new List<TypeCheckedStatement>();
+        foreach (var statement in block)
+        {
+            result.AddRange(RewriteStatement(statement));
+            if (result.Count > 0 && result[^1].IsReturn)
+            {
+                break;
+            }
+        }
+
+        return RemoveDeadStores(result);
+    }
+
+    protected override IEnumerable<TypeCheckedStatement> RewriteStatement(
+        TypeCheckedStatement statement
+    )
+    {
+        var rewritten = RewriteChildren(statement);
+
+        switch (rewritten)
+        {
+            case TypeCheckedConditional { Condition: TypeCheckedBooleanLiteral condition } c:
+                var taken = condition.Value ? c.TrueBlock : c.FalseBlock;
+                // The branch is its own scope, which only matters if it declares something.
+                if (taken.Any(s => s is TypeCheckedVar or TypeCheckedFunctionDeclaration))
+                {
+                    return
+                    [
+                        new TypeCheckedConditional
+                        {
+                            Condition = new TypeCheckedBooleanLiteral { Value = true },
+                            TrueBlock = taken,
+                            FalseBlock = [],
+                            Line = c.Line,
+                        },
+                    ];
+                }
+                return taken;
+            case TypeCheckedLoop { Condition: TypeCheckedBooleanLiteral { Value: false } }:
+                return [];
+            case TypeCheckedExpression e when Effects.IsPure(e):
+                return [];
+            case TypeCheckedVar v when !_read.Contains(v.Name):
+                return Discard(v.Value, v.Line);
+            case TypeCheckedAssignment { Lhs: TypeCheckedIdentifier i } a
+                when !_read.Contains(i.Name):
+                return Discard(a.Rhs, a.Line);
+            default:
+                return [rewritten];
+        }
+    }
+
+    // What's left of a statement once its value is unused: the value itself, if it has side effects.
+    private static IEnumerable<TypeCheckedStatement> Discard(
+        TypeCheckedExpression value,
+        int? line
+    )
+    {
+        if (Effects.IsPure(value))
+        {
+            return [];
+        }
+        value.Line ??= line;
+        return [value];
+    }
+
+    // Within one block: a store to a variable is dead if a later statement of the same block
+    // assigns to it again before anything reads it. (There is no `break` or `continue`, so
+    // reaching the later statement is only prevented by returning, after which locals are dead
+    // anyway.)
+    private static List<TypeCheckedStatement> RemoveDeadStores(List<TypeCheckedStatement> block)
+    {
+        var live = new List<TypeCheckedStatement>(block.Count);
+        for (var k = 0; k < block.Count; ++k)
+        {
+            if (
+                block[k] is TypeCheckedAssignment { Lhs: TypeCheckedIdentifier target } a
+                && IsOverwrittenBeforeRead(block, k, target.Name)
+            )
+            {
+                live.AddRange(Discard(a.Rhs, a.Line));
+            }
+            else
+            {
+                live.Add(block[k]);
+            }
+        }
+
+        // A declaration must stay, but it can take the value of an assignment right after it.
+        var result = new List<TypeCheckedStatement>(live.Count);
+        for (var k = 0; k < live.Count; ++k)
+        {
+            if (
+                live[k] is TypeCheckedVar v
+                && Effects.IsPure(v.Value)
+                && k + 1 < live.Count
+                && live[k + 1] is TypeCheckedAssignment { Lhs: TypeCheckedIdentifier next } store
+                && next.Name == v.Name
+                && !Effects.ReadVariables(store.Rhs).Contains(v.Name)
+            )
+            {
+                result.Add(
+                    new TypeCheckedVar
+                    {
+                        Name = v.Name,
+                        Type = v.Type,
+                        Value = store.Rhs,
+                        Line = store.Line,
+                    }
+                );
+                ++k;
+            }
+            else
+            {
+                result.Add(live[k]);
+            }
+        }
+
+        return result;
+    }
+
+    private static bool IsOverwrittenBeforeRead(
+        List<TypeCheckedStatement> block,
+        int index,
+        string name
+    )
+    {
+        for (var j = index + 1; j < block.Count; ++j)
+        {
+            var statement = block[j];
+            if (
+                statement is TypeCheckedAssignment { Lhs: TypeCheckedIdentifier i } a
+                && i.Name == name
+                && !Effects.ReadVariables(a.Rhs).Contains(name)
+            )
+            {
+                return true;
+            }
+            if (Effects.Reads(statement, name))
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,290 @@
+using Compiler.Models;
+
+namespace Compiler.Components.Passes;
+
+// What evaluating a piece of the tree can do besides produce a value, as far as the passes care.
+//
+// Functions receive their arguments by value and can't see the caller's variables, and arrays are
+// copy-on-write values, so the only ways to change a variable are to assign to it (or to an element
+// of it) or to call a mutating method on it. Everything here is conservative: variables are
+// tracked by name, ignoring shadowing.
+public static class Effects
+{
+    // Methods that neither change their receiver nor can fail, keyed by receiver and method name.
+    private static readonly IReadOnlySet<(string, string)> PureMethods = new HashSet<(
+        string,
+        string
+    )>
+    {
+        ("String", "length"),
+        ("String", "find"),
+        ("String", "contains"),
+        ("String", "startsWith"),
+        ("String", "endsWith"),
+        ("String", "count"),
+        ("String", "compare"),
+        ("String", "split"),
+        ("Array", "length"),
+        ("Optional", "hasValue"),
+    };
+
+    // Methods that don't change their receiver, but panic on bad arguments.
+    private static readonly IReadOnlySet<(string, string)> FallibleMethods = new HashSet<(
+        string,
+        string
+    )>
+    {
+        ("String", "substring"),
+    };
+
+    private static readonly IReadOnlySet<(string, string)> MutatingMethods = new HashSet<(
+        string,
+        string
+    )>
+    {
+        ("Array", "push"),
+        ("Array", "pop"),
+        ("Array", "clear"),
+        ("LineIterator", "next"),
+    };
+
+    private static readonly IReadOnlySet<Method> PureFunctions = BuiltIns
+        .Methods.Where(m => m.Name is "parseInt" or "parseDouble")
+        .ToHashSet();
+
+    // The parallel builtins only accept functions without side effects, but those may still divide
+    // by zero or never return.
+    private static readonly IReadOnlySet<Method> FallibleFunctions = BuiltIns
+        .Methods.Where(m => m.Name is "parallelMap" or "parallelReduce")
+        .ToHashSet();
+
+    public static bool IsMutating(Method m) => MutatingMethods.Contains((m.ThisType.Name, m.Name));
+
+    public static bool IsPureMethod(Method m) => PureMethods.Contains((m.ThisType.Name, m.Name));
+
+    private static bool IsFallible(Method m) => FallibleMethods.Contains((m.ThisType.Name, m.Name));
+
+    // Whether evaluating `expr` has no side effects and can't fail, so it may be dropped, or
+    // evaluated earlier or more often than written.
+    public static bool IsPure(TypeCheckedExpression expr) => Check(expr, allowFailure: false);
+
+    // Whether evaluating `expr` has no side effects, though it may panic (e.g. an index out of
+    // bounds). Such an expression may be evaluated fewer times than written, but not dropped.
+    public static bool IsSideEffectFree(TypeCheckedExpression expr) =>
+        Check(expr, allowFailure: true);
+
+    private static bool Check(TypeCheckedExpression expr, bool allowFailure) =>
+        expr switch
+        {
+            TypeCheckedFunctionCall fc => (
+                PureFunctions.Contains(fc.Method)
+                || (allowFailure && FallibleFunctions.Contains(fc.Method))
+            )
+                && fc.Arguments.All(a => Check(a, allowFailure)),
+            // Formatting anything but strings and primitives may call an overridden toString().
+            TypeCheckedStringInterpolation si => si.Pieces.All(p =>
+                (p.Type == BuiltIns.String || BuiltIns.PrimitiveTypes.Contains(p.Type))
+                && Check(p, allowFailure)
+            ),
+            TypeCheckedOperatorCall o => (allowFailure || !CanFail(o))
+                && (o.Lhs is null || Check(o.Lhs, allowFailure))
+                && (o.Rhs is null || Check(o.Rhs, allowFailure)),
+            TypeCheckedIndexAccess ia => allowFailure
+                && Check(ia.Base, allowFailure)
+                && Check(ia.Index, allowFailure),
+            TypeCheckedCastExpression cast => Check(cast.Base, allowFailure),
+            TypeCheckedArrayLiteral al => al.Values.All(v => Check(v, allowFailure)),
+            TypeCheckedPropertyAccess pa => Check(pa.Base, allowFailure),
+            TypeCheckedMethodCall mc => (
+                IsPureMethod(mc.Method) || (allowFailure && IsFallible(mc.Method))
+            )
+                && Check(mc.Base, allowFailure)
+                && mc.Arguments.All(a => Check(a, allowFailure)),
+            TypeCheckedIdentifier
+            or TypeCheckedFunctionReference
+            or TypedIntegerLiteral
+            or TypedDecimalLiteral
+            or TypeCheckedStringLiteral
+            or TypeCheckedCharLiteral
+            or TypeCheckedBooleanLiteral
+            or TypeCheckedNullLiteral => true,
+            _ => false,
+        };
+
+    // Integer division by zero is undefined behavior rather than a panic, but it still mustn't be
+    // introduced where the program didn't already risk it.
+    private static bool CanFail(TypeCheckedOperatorCall o) =>
+        o.Operator.Name is "/" or "%"
+        && BuiltIns.IntegerTypes.Contains(o.Operator.ReturnType)
+        && !(o.Rhs is TypedIntegerLiteral { Value: not 0 and not -1 });
+
+    // Whether `expr` is one of the literals the passes can compute with.
+    public static bool IsConstant(TypeCheckedExpression expr) =>
+        expr
+            is TypedIntegerLiteral
+                or TypedDecimalLiteral
+                or TypeCheckedStringLiteral
+                or TypeCheckedCharLiteral
+                or TypeCheckedBooleanLiteral;
+
+    // The variable a place belongs to: `a` for `a`, `a[i]` and `a[i].b`.
+    public static string? RootVariable(TypeCheckedExpression place) =>
+        place switch
+        {
+            TypeCheckedIdentifier i => i.Name,
+            TypeCheckedIndexAccess ia => RootVariable(ia.Base),
+            TypeCheckedPropertyAccess pa => RootVariable(pa.Base),
+            _ => null,
+        };
+
+    // Every variable name that appears in `expr`.
+    public static ISet<string> ReadVariables(TypeCheckedExpression expr)
+    {
+        var result = new HashSet<string>();
+        foreach (var node in Subexpressions(expr))
+        {
+            if (node is TypeCheckedIdentifier i)
+            {
+                result.Add(i.Name);
+            }
+        }
+        return result;
+    }
+
+    // Variables that `statements` declare, assign to, or mutate, including in nested blocks but
+    // not in nested function declarations.
+    public static ISet<string> WrittenVariables(IEnumerable<TypeCheckedStatement> statements)
+    {
+        var result = new HashSet<string>();
+        foreach (var statement in Statements(statements))
+        {
+            if (statement is TypeCheckedVar v)
+            {
+                result.Add(v.Name);
+            }
+            else if (statement is TypeCheckedForLoop f)
+            {
+                result.Add(f.Variable);
+            }
+            else if (statement is TypeCheckedAssignment a && RootVariable(a.Lhs) is string name)
+            {
+                result.Add(name);
+            }
+
+            foreach (var expr in TopLevelExpressions(statement))
+            {
+                foreach (var node in Subexpressions(expr))
+                {
+                    if (
+                        node is TypeCheckedMethodCall mc
+                        && IsMutating(mc.Method)
+                        && RootVariable(mc.Base) is string receiver
+                    )
+                    {
+                        result.Add(receiver);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    // Variables that are the target of a plain assignment somewhere in `statements`, including in
+    // nested blocks but not in nested function declarations. Declarations don't count, but the
+    // variable of a `for` loop is assigned on every iteration.
+    public static ISet<string> AssignedVariables(IEnumerable<TypeCheckedStatement> statements) =>
+        Statements(statements)
+            .Select(s =>
+                s switch
+                {
+                    TypeCheckedAssignment a => RootVariable(a.Lhs),
+                    TypeCheckedForLoop f => f.Variable,
+                    _ => null,
+                }
+            )
+            .OfType<string>()
+            .ToHashSet();
+
+    // Whether `statement` reads `name` anywhere. Being assigned to as a whole isn't a read, but
+    // having an element assigned to is.
+    public static bool Reads(TypeCheckedStatement statement, string name) =>
+        Statements([statement])
+            .SelectMany(TopLevelExpressions)
+            .SelectMany(Subexpressions)
+            .Any(node => node is TypeCheckedIdentifier i && i.Name == name);
+
+    // `statements` and every statement nested in them, except inside function declarations.
+    public static IEnumerable<TypeCheckedStatement> Statements(
+        IEnumerable<TypeCheckedStatement> statements
+    )
+    {
+        foreach (var statement in statements)
+        {
+            yield return statement;
+
+            IEnumerable<TypeCheckedStatement> nested = statement switch
+            {
+                TypeCheckedConditional c => Statements(c.TrueBlock)
+                    .Concat(Statements(c.FalseBlock)),
+                TypeCheckedLoop l => Statements(l.Body),
+                TypeCheckedForLoop f => Statements(f.Body),
+                _ => [],
+            };
+            foreach (var inner in nested)
+            {
+                yield return inner;
+            }
+        }
+    }
+
+    // The expressions a statement evaluates itself, not counting nested blocks. Plain assignment
+    // targets are left out, since assigning to a variable doesn't read it.
+    public static IEnumerable<TypeCheckedExpression> TopLevelExpressions(
+        TypeCheckedStatement statement
+    ) =>
+        statement switch
+        {
+            TypeCheckedVar v => [v.Value],
+            TypeCheckedAssignment { Lhs: TypeCheckedIdentifier } a => [a.Rhs],
+            TypeCheckedAssignment a => [a.Lhs, a.Rhs],
+            TypeCheckedConditional c => [c.Condition],
+            TypeCheckedLoop l => [l.Condition],
+            TypeCheckedRangeLoop r => [r.Start, r.End],
+            TypeCheckedArrayLoop a => [a.Array],
+            TypeCheckedReturnStatement { Value: not null } rs => [rs.Value],
+            TypeCheckedExpression e => [e],
+            _ => [],
+        };
+
+    // `expr` and everything nested in it, parents first.
+    public static IEnumerable<TypeCheckedExpression> Subexpressions(TypeCheckedExpression expr)
+    {
+        yield return expr;
+        foreach (var child in Children(expr))
+        {
+            foreach (var node in Subexpressions(child))
+            {
+                yield return node;
+            }
+        }
+    }
+
+    public static IEnumerable<TypeCheckedExpression> Children(TypeCheckedExpression expr) =>
+        expr switch
+        {
+            TypeCheckedFunctionCall fc => fc.Arguments,
+            TypeCheckedStringInterpolation si => si.Pieces,
+            TypeCheckedOperatorCall o => new[] { o.Lhs, o.Rhs }.OfType<TypeCheckedExpression>(),
+            TypeCheckedIndexAccess ia => [ia.Base, ia.Index],
+            TypeCheckedCastExpression cast => [cast.Base],
+            TypeCheckedAwait aw => [aw.Operand],
+            TypeCheckedArrayLiteral al => al.Values,
+            TypeCheckedPropertyAccess pa => [pa.Base],
+            TypeCheckedMethodCall mc => mc.Arguments.Prepend(mc.Base),
+            _ => [],
+        };
+
+    // Whether the right-hand side of `o` is only evaluated depending on the left-hand side.
+    public static bool ShortCircuits(TypeCheckedOperatorCall o) =>
+        o.Operator.LambdaWrapRhs || o.Operator.Name is "&&" or "||";
+}
@@ -0,0 +1,24 @@
+using Compiler.Models;
+using Compiler.Util;
+
+namespace Compiler.Components.Passes;
+
+// Replaces every occurrence of some expressions, identified by their printed form, with variables
+// holding their values. Places being assigned to or mutated are left alone, and so are the bodies
+// of nested functions, whose identifiers may name their own arguments and which can't see the
+// variables being substituted in.
+public class ExpressionReplacer(IReadOnlyDictionary<string, TypeCheckedIdentifier> replacements)
+    : TreeRewriter
+{
+    public TypeCheckedStatement Rewrite(TypeCheckedStatement statement) =>
+        RewriteChildren(statement);
+
+    protected override List<TypeCheckedStatement> RewriteFunctionBody(
+        TypeCheckedFunctionDeclaration fd
+    ) => fd.Body.ToList();
+
+    protected override TypeCheckedExpression RewriteExpression(TypeCheckedExpression expr) =>
+        replacements.TryGetValue(IrPrinter.PrintExpression(expr), out var replacement)
+            ? replacement
+            : RewriteExpressionChildren(expr);
+}
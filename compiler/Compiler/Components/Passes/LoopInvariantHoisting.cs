@@ -0,0 +1,81 @@
+using Compiler.Models;
+using Compiler.Util;
+
+namespace Compiler.Components.Passes;
+
+// Moves method calls that give the same result on every iteration, such as `s.length()` in a loop
+// condition, into a variable computed once before the loop. Only calls that can't fail and have
+// no side effects are moved, since the loop might not run at all.
+public class LoopInvariantHoisting(TemporaryNames names) : TreeRewriter
+{
+    protected override IEnumerable<TypeCheckedStatement> RewriteStatement(
+        TypeCheckedStatement statement
+    )
+    {
+        // Inner loops go first, so that what they hoist can be considered for this loop.
+        var rewritten = RewriteChildren(statement);
+        if (rewritten is not (TypeCheckedLoop or TypeCheckedForLoop))
+        {
+            return [rewritten];
+        }
+        var loop = rewritten;
+
+        var written = Effects.WrittenVariables([loop]);
+        var hoisted = new Dictionary<string, TypeCheckedIdentifier>();
+        var result = new List<TypeCheckedStatement>();
+
+        foreach (var candidate in Candidates(loop, written))
+        {
+            var key = IrPrinter.PrintExpression(candidate);
+            if (hoisted.ContainsKey(key))
+            {
+                continue;
+            }
+
+            var temporary = new TypeCheckedIdentifier
+            {
+                Name = names.Next("licm"),
+                Type = candidate.Type,
+            };
+            hoisted[key] = temporary;
+            result.Add(
+                new TypeCheckedVar
+                {
+                    Name = temporary.Name,
+                    Type = temporary.Type,
+                    Value = candidate,
+                    Line = loop.Line,
+                }
+            );
+        }
+
+        if (hoisted.Count == 0)
+        {
+            return [loop];
+        }
+
+        result.Add(new ExpressionReplacer(hoisted).Rewrite(loop));
+        return result;
+    }
+
+    // The outermost invariant calls in the loop's condition, or what it iterates over, and body.
+    private static IEnumerable<TypeCheckedExpression> Candidates(
+        TypeCheckedStatement loop,
+        ISet<string> written
+    )
+    {
+        bool IsInvariant(TypeCheckedExpression expr) =>
+            expr is TypeCheckedMethodCall mc
+            && Effects.IsPureMethod(mc.Method)
+            && Effects.IsPure(expr)
+            && !Effects.ReadVariables(expr).Overlaps(written);
+
+        IEnumerable<TypeCheckedExpression> Outermost(TypeCheckedExpression expr) =>
+            IsInvariant(expr) ? [expr] : Effects.Children(expr).SelectMany(Outermost);
+
+        return Effects
+            .Statements([loop])
+            .SelectMany(Effects.TopLevelExpressions)
+            .SelectMany(Outermost);
+    }
+}
@@ -0,0 +1,60 @@
+using Compiler.Models;
+
+namespace Compiler.Components.Passes;
+
+// Hands out names for variables introduced by the passes and Codegen, avoiding every name the
+// program already uses.
+public class TemporaryNames
+{
+    private readonly HashSet<string> _used;
+    private uint _count = 0;
+
+    public TemporaryNames(IEnumerable<TypeCheckedStatement> program)
+    {
+        _used = [];
+        Collect(program);
+    }
+
+    public string Next(string prefix)
+    {
+        string name;
+        do
+        {
+            name = $"{prefix}{_count}";
+            ++_count;
+        } while (!_used.Add(name));
+        return name;
+    }
+
+    private void Collect(IEnumerable<TypeCheckedStatement> statements)
+    {
+        foreach (var statement in statements)
+        {
+            switch (statement)
+            {
+                case TypeCheckedVar v:
+                    _used.Add(v.Name);
+                    break;
+                case TypeCheckedFunctionDeclaration fd:
+                    _used.Add(fd.Method.Name);
+                    _used.UnionWith(fd.Arguments.Select(a => a.Name));
+                    Collect(fd.Body);
+                    break;
+                case TypeCheckedConditional c:
+                    Collect(c.TrueBlock);
+                    Collect(c.FalseBlock);
+                    break;
+                case TypeCheckedLoop l:
+                    Collect(l.Body);
+                    break;
+                case TypeCheckedForLoop f:
+                    _used.Add(f.Variable);
+                    Collect(f.Body);
+                    break;
+                case TypeCheckedClass cd:
+                    Collect(cd.Body);
+                    break;
+            }
+        }
+    }
+}
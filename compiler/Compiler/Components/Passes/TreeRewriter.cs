@@ -0,0 +1,173 @@
+using Compiler.Models;
+
+namespace Compiler.Components.Passes;
+
+// Copies a type-checked tree, giving passes a hook at each block, statement and expression. The
+// default hooks rebuild the node around rewritten children, so a pass only overrides what it
+// changes. Trees are never modified in place; passes may share untouched nodes between the input
+// and output.
+public abstract class TreeRewriter
+{
+    public virtual List<TypeCheckedStatement> Run(IEnumerable<TypeCheckedStatement> program) =>
+        RewriteBlock(program);
+
+    protected virtual List<TypeCheckedStatement> RewriteBlock(
+        IEnumerable<TypeCheckedStatement> block
+    )
+    {
+        var result = new List<TypeCheckedStatement>();
+        foreach (var statement in block)
+        {
+            result.AddRange(RewriteStatement(statement));
+        }
+        return result;
+    }
+
+    // Returns the statements that replace `statement`, which may be none.
+    protected virtual IEnumerable<TypeCheckedStatement> RewriteStatement(
+        TypeCheckedStatement statement
+    ) => [RewriteChildren(statement)];
+
+    protected virtual List<TypeCheckedStatement> RewriteFunctionBody(
+        TypeCheckedFunctionDeclaration fd
+    ) => RewriteBlock(fd.Body);
+
+    // The result keeps the statement's line. An expression may come back as a node shared with
+    // another part of the tree, which is given the line if it has none; only statements' lines are
+    // ever read, so that does no harm.
+    protected TypeCheckedStatement RewriteChildren(TypeCheckedStatement statement)
+    {
+        var rewritten = RewriteChildrenWithoutLine(statement);
+        rewritten.Line ??= statement.Line;
+        return rewritten;
+    }
+
+    private TypeCheckedStatement RewriteChildrenWithoutLine(TypeCheckedStatement statement) =>
+        statement switch
+        {
+            TypeCheckedVar v => new TypeCheckedVar
+            {
+                Name = v.Name,
+                Type = v.Type,
+                Value = RewriteExpression(v.Value),
+            },
+            TypeCheckedAssignment a => new TypeCheckedAssignment
+            {
+                Lhs = RewriteTarget(a.Lhs),
+                Rhs = RewriteExpression(a.Rhs),
+            },
+            TypeCheckedConditional c => new TypeCheckedConditional
+            {
+                Condition = RewriteExpression(c.Condition),
+                TrueBlock = RewriteBlock(c.TrueBlock),
+                FalseBlock = RewriteBlock(c.FalseBlock),
+            },
+            TypeCheckedLoop l => new TypeCheckedLoop
+            {
+                Condition = RewriteExpression(l.Condition),
+                Body = RewriteBlock(l.Body),
+            },
+            TypeCheckedRangeLoop r => new TypeCheckedRangeLoop
+            {
+                Variable = r.Variable,
+                VariableType = r.VariableType,
+                Start = RewriteExpression(r.Start),
+                End = RewriteExpression(r.End),
+                Body = RewriteBlock(r.Body),
+            },
+            TypeCheckedArrayLoop a => new TypeCheckedArrayLoop
+            {
+                Variable = a.Variable,
+                VariableType = a.VariableType,
+                Array = RewriteExpression(a.Array),
+                Body = RewriteBlock(a.Body),
+            },
+            TypeCheckedFunctionDeclaration fd => new TypeCheckedFunctionDeclaration
+            {
+                Method = fd.Method,
+                Arguments = fd.Arguments,
+                Body = RewriteFunctionBody(fd),
+                IsAsync = fd.IsAsync,
+            },
+            TypeCheckedReturnStatement rs => new TypeCheckedReturnStatement
+            {
+                Value = rs.Value is null ? null : RewriteExpression(rs.Value),
+            },
+            TypeCheckedExpression e => RewriteExpression(e),
+            _ => statement,
+        };
+
+    protected virtual TypeCheckedExpression RewriteExpression(TypeCheckedExpression expr) =>
+        RewriteExpressionChildren(expr);
+
+    protected TypeCheckedExpression RewriteExpressionChildren(TypeCheckedExpression expr) =>
+        expr switch
+        {
+            TypeCheckedFunctionCall fc => new TypeCheckedFunctionCall
+            {
+                Method = fc.Method,
+                Arguments = fc.Arguments.Select(RewriteExpression).ToList(),
+            },
+            TypeCheckedStringInterpolation si => new TypeCheckedStringInterpolation
+            {
+                Pieces = si.Pieces.Select(RewriteExpression).ToList(),
+            },
+            TypeCheckedOperatorCall o => new TypeCheckedOperatorCall
+            {
+                Operator = o.Operator,
+                Lhs = o.Lhs is null ? null : RewriteExpression(o.Lhs),
+                Rhs = o.Rhs is null ? null : RewriteExpression(o.Rhs),
+            },
+            TypeCheckedIndexAccess ia => new TypeCheckedIndexAccess
+            {
+                Base = RewriteExpression(ia.Base),
+                Index = RewriteExpression(ia.Index),
+            },
+            TypeCheckedCastExpression cast => new TypeCheckedCastExpression
+            {
+                Base = RewriteExpression(cast.Base),
+                Type = cast.Type,
+            },
+            TypeCheckedAwait aw => new TypeCheckedAwait { Operand = RewriteExpression(aw.Operand) },
+            TypeCheckedArrayLiteral al => new TypeCheckedArrayLiteral
+            {
+                Values = al.Values.Select(RewriteExpression).ToList(),
+                Type = al.Type,
+            },
+            TypeCheckedPropertyAccess pa => new TypeCheckedPropertyAccess
+            {
+                Base = RewriteExpression(pa.Base),
+                Property = pa.Property,
+            },
+            // The receiver of a mutating method is a place being changed, not a value being read.
+            TypeCheckedMethodCall mc => new TypeCheckedMethodCall
+            {
+                Base = Effects.IsMutating(mc.Method)
+                    ? RewriteTarget(mc.Base)
+                    : RewriteExpression(mc.Base),
+                Arguments = mc.Arguments.Select(RewriteExpression).ToList(),
+                Method = mc.Method,
+            },
+            // Literals and identifiers
+            _ => expr,
+        };
+
+    // Rewrites a place being assigned to or mutated. The variable at its root and the chain of
+    // accesses leading to the place stay as they are; only the indices are ordinary reads.
+    protected TypeCheckedExpression RewriteTarget(TypeCheckedExpression target) =>
+        target switch
+        {
+            TypeCheckedIdentifier => target,
+            TypeCheckedIndexAccess ia => new TypeCheckedIndexAccess
+            {
+                Base = RewriteTarget(ia.Base),
+                Index = RewriteExpression(ia.Index),
+            },
+            TypeCheckedPropertyAccess pa => new TypeCheckedPropertyAccess
+            {
+                Base = RewriteTarget(pa.Base),
+                Property = pa.Property,
+            },
+            _ => RewriteExpression(target),
+        };
+}
@@ -4,35 +4,55 @@ namespace Compiler.Components;
 
 public class TypeChecker
 {
-    private List<Models.Type> _knownTypes;
-    private List<Variable> _knownVariables;
-    private List<Method> _knownFunctions;
-    private readonly int _scopeStart;
+    // Where `await` is allowed. At the top level it runs the event loop until the task is done; in
+    // an async function it suspends the function instead.
+    private enum AwaitContext
+    {
+        None,
+        TopLevel,
+        AsyncFunction,
+    }
+
+    private readonly Scope<string, Models.Type> _knownTypes;
+    private readonly Scope<string, Variable> _knownVariables;
+    private readonly Scope<string, Method> _knownFunctions;
+    private readonly Dictionary<FunctionDeclaration, Method> _declaredFunctions = [];
+    private readonly Dictionary<
+        (Expression, Models.Type?),
+        CheckResult<TypeCheckedExpression>
+    > _checkedExpressions = [];
 
     private readonly List<ulong> _lineCounts;
+    private readonly TextWriter _warnings;
+    private AwaitContext _awaitContext = AwaitContext.TopLevel;
 
-    public TypeChecker(List<ulong> lineCounts)
+    // Warnings go to `warnings`, which the compile server passes so that they reach its client
+    // rather than its own stderr.
+    public TypeChecker(List<ulong> lineCounts, TextWriter? warnings = null)
     {
         _lineCounts = lineCounts;
-        _knownTypes = BuiltIns.Types.ToList();
-        _knownVariables = [];
-        _knownFunctions = BuiltIns.Methods.ToList();
-        _scopeStart = 0;
+        _warnings = warnings ?? Console.Error;
+        _knownTypes = new(t => t.Name, BuiltIns.Types);
+        _knownVariables = new(v => v.Name);
+        _knownFunctions = new(m => m.Name, BuiltIns.Methods);
     }
 
     public TypeChecker(TypeChecker other)
     {
         _lineCounts = other._lineCounts;
-        _knownTypes = [.. other._knownTypes];
-        _knownVariables = [.. other._knownVariables];
-        _knownFunctions = [.. other._knownFunctions];
-        _scopeStart = _knownVariables.Count;
+        _warnings = other._warnings;
+        _awaitContext = other._awaitContext;
+        _knownTypes = other._knownTypes.Nested();
+        _knownVariables = other._knownVariables.Nested();
+        _knownFunctions = other._knownFunctions.Nested();
     }
 
+    // Every statement is looked up now, so this is a binary search rather than a scan of the file.
     private int GetLineNumber(Location loc)
     {
-        var maybeLineNumber = _lineCounts.FindIndex(x => x >= loc.Pos);
-        return maybeLineNumber < 0 ? _lineCounts.Count + 1 : maybeLineNumber + 1;
+        // The index of the first newline at or after the position.
+        var index = _lineCounts.BinarySearch(loc.Pos);
+        return (index < 0 ? ~index : index) + 1;
     }
 
     private int? GetLineNumber(HasLocation node)
@@ -44,6 +64,40 @@ public class TypeChecker
         return null;
     }
 
+    // Declares the top-level functions of a module ahead of CheckTypes, returning them so that other
+    // modules can import them. Only the main module may have other top-level statements.
+    public IReadOnlyList<Method> DeclareFunctions(IEnumerable<AstNode> program, bool isMain)
+    {
+        if (!isMain && program.FirstOrDefault(n => n is not FunctionDeclaration) is AstNode node)
+        {
+            throw new TypeCheckException(
+                "Only functions can be declared at the top level of a file other than the first",
+                GetLineNumber(node)
+            );
+        }
+
+        return program.OfType<FunctionDeclaration>().Select(CheckFunctionTypeFirstPass).ToList();
+    }
+
+    public void Import(IEnumerable<Method> functions, string origin)
+    {
+        foreach (var method in functions)
+        {
+            var overlaps = _knownFunctions
+                .Lookup(method.Name)
+                .Where(m => m.OverlapsWith(method))
+                .ToList();
+            if (overlaps.Count > 0)
+            {
+                throw new TypeCheckException(
+                    $"Possible duplicate declaration: {method} in {origin} is too similar to: {string.Join("; ", overlaps)}",
+                    overlaps[0].Declaration is FunctionDeclaration fd ? GetLineNumber(fd) : null
+                );
+            }
+            _knownFunctions.Add(method);
+        }
+    }
+
     public IEnumerable<TypeCheckedStatement> CheckTypes(
         IEnumerable<AstNode> program,
         Models.Type? returnType = null
@@ -51,195 +105,395 @@ public class TypeChecker
     {
         foreach (var cd in program.OfType<ClassDefinition>())
         {
-            yield return CheckClassDefinition(cd);
+            var statement = CheckClassDefinition(cd);
+            statement.Line = GetLineNumber(cd);
+            yield return statement;
         }
 
         foreach (var fd in program.OfType<FunctionDeclaration>())
         {
-            CheckFunctionTypeFirstPass(fd);
+            if (!_declaredFunctions.ContainsKey(fd))
+            {
+                CheckFunctionTypeFirstPass(fd);
+            }
         }
 
         foreach (var node in program.Where(node => node is not ClassDefinition))
         {
-            if (node is ReturnStatement rs)
+            var statement = CheckStatement(node, returnType);
+            statement.Line = GetLineNumber(node);
+            yield return statement;
+        }
+    }
+
+    private TypeCheckedStatement CheckStatement(AstNode node, Models.Type? returnType)
+    {
+        if (node is ReturnStatement rs)
+        {
+            if (returnType is null)
             {
-                if (returnType is null)
-                {
-                    throw new TypeCheckException(
-                        "Top-level return statements are not allowed",
-                        GetLineNumber(node)
-                    );
-                }
-                if (rs.Value is null && returnType != BuiltIns.Void)
-                {
-                    throw new TypeCheckException(
-                        "Return statement in non-Void function must return value",
-                        GetLineNumber(node)
-                    );
-                }
+                throw new TypeCheckException(
+                    "Top-level return statements are not allowed",
+                    GetLineNumber(node)
+                );
+            }
+            if (rs.Value is null && returnType != BuiltIns.Void)
+            {
+                throw new TypeCheckException(
+                    "Return statement in non-Void function must return value",
+                    GetLineNumber(node)
+                );
+            }
 
-                TypeCheckedExpression? value = null;
-                if (rs.Value is not null)
-                {
-                    value = CheckExpressionType(rs.Value, returnType);
-                }
-                yield return new TypeCheckedReturnStatement { Value = value };
+            TypeCheckedExpression? value = null;
+            if (rs.Value is not null)
+            {
+                value = CheckExpressionType(rs.Value, returnType);
             }
-            else if (node is VarDeclaration vd)
+            return new TypeCheckedReturnStatement { Value = value };
+        }
+        else if (node is VarDeclaration vd)
+        {
+            if (_knownVariables.DeclaresLocally(vd.Name))
             {
-                if (VariableNameExistsInLocalScope(vd.Name))
-                {
-                    throw new TypeCheckException(
-                        $"Invalid redeclaration of variable {vd.Name}",
-                        GetLineNumber(vd)
-                    );
-                }
+                throw new TypeCheckException(
+                    $"Invalid redeclaration of variable {vd.Name}",
+                    GetLineNumber(vd)
+                );
+            }
 
-                var declType =
-                    LookupType(vd.DeclaredType)
-                    ?? throw new TypeCheckException(
-                        $"Unrecognized type {vd.DeclaredType}",
-                        GetLineNumber(vd.DeclaredType)
-                    );
-                var checkedValue = CheckExpressionType(vd.Value, declType);
-                var variable = new Variable { Name = vd.Name, Type = declType };
-                _knownVariables.Add(variable);
-                yield return new TypeCheckedVar
-                {
-                    Name = vd.Name,
-                    Type = declType,
-                    Value = checkedValue,
-                };
+            var declType =
+                LookupType(vd.DeclaredType)
+                ?? throw new TypeCheckException(
+                    $"Unrecognized type {vd.DeclaredType}",
+                    GetLineNumber(vd.DeclaredType)
+                );
+            var checkedValue = CheckExpressionType(vd.Value, declType);
+            var variable = new Variable { Name = vd.Name, Type = declType };
+            _knownVariables.Add(variable);
+            return new TypeCheckedVar
+            {
+                Name = vd.Name,
+                Type = declType,
+                Value = checkedValue,
+            };
+        }
+        else if (node is Assignment a)
+        {
+            if (a.Lhs is CastExpression)
+            {
+                throw new TypeCheckException(
+                    "The member chain on the left of an assignment cannot end in a cast",
+                    GetLineNumber(a.Lhs)
+                );
             }
-            else if (node is Assignment a)
+            var lhs = CheckExpressionType(a.Lhs, null);
+            if (lhs is TypeCheckedMethodCall)
             {
-                if (a.Lhs is CastExpression)
-                {
-                    throw new TypeCheckException(
-                        "The member chain on the left of an assignment cannot end in a cast",
-                        GetLineNumber(a.Lhs)
-                    );
-                }
-                var lhs = CheckExpressionType(a.Lhs, null);
-                if (lhs is TypeCheckedMethodCall)
-                {
-                    throw new TypeCheckException(
-                        "The member chain on the left of an assignment cannot end in a method call",
-                        GetLineNumber(a.Lhs)
-                    );
-                }
-                else if (lhs is TypeCheckedIndexAccess ia && !ia.Subscript.IsSettable)
-                {
-                    throw new TypeCheckException(
-                        $"The subscript on {ia.Base.Type} is not settable",
-                        GetLineNumber(a.Lhs)
-                    );
-                }
+                throw new TypeCheckException(
+                    "The member chain on the left of an assignment cannot end in a method call",
+                    GetLineNumber(a.Lhs)
+                );
+            }
+            else if (lhs is TypeCheckedIndexAccess ia && !ia.Subscript.IsSettable)
+            {
+                throw new TypeCheckException(
+                    $"The subscript on {ia.Base.Type} is not settable",
+                    GetLineNumber(a.Lhs)
+                );
+            }
 
-                var rhs = CheckExpressionType(a.Rhs, lhs.Type);
+            var rhs = CheckExpressionType(a.Rhs, lhs.Type);
 
-                yield return new TypeCheckedAssignment { Lhs = lhs, Rhs = rhs };
+            return new TypeCheckedAssignment { Lhs = lhs, Rhs = rhs };
+        }
+        else if (node is ConditionalStatement cs)
+        {
+            if (!cs.TrueBlock.Any())
+            {
+                _warnings.WriteLine("Warning: empty if statement");
             }
-            else if (node is ConditionalStatement cs)
+            if (cs.FalseBlock?.Count() == 0)
             {
-                if (!cs.TrueBlock.Any())
-                {
-                    Console.Error.WriteLine("Warning: empty if statement");
-                }
-                if (cs.FalseBlock?.Count() == 0)
-                {
-                    Console.Error.WriteLine("Warning: Extraneous else block");
-                }
+                _warnings.WriteLine("Warning: Extraneous else block");
+            }
 
-                if (
-                    cs.TrueBlock.Any(x => x is ClassDefinition)
-                    || (cs.FalseBlock is not null && cs.FalseBlock.Any(x => x is ClassDefinition))
-                )
-                {
-                    var lineNumber = Enumerable
-                        .Concat(cs.TrueBlock, cs.FalseBlock ?? [])
-                        .OfType<ClassDefinition>()
-                        .Select(x => GetLineNumber(x))
-                        .FirstOrDefault(x => x is not null);
-
-                    throw new TypeCheckException(
-                        "Conditional class definitions are forbidden",
-                        lineNumber
-                    );
-                }
+            ForbidClassDefinitions(Enumerable.Concat(cs.TrueBlock, cs.FalseBlock ?? []));
 
-                var condition = CheckExpressionType(cs.Condition, BuiltIns.Bool);
-                var trueBlock = new TypeChecker(this).CheckTypes(cs.TrueBlock, returnType);
-                IEnumerable<TypeCheckedStatement> falseBlock = [];
-                if (cs.FalseBlock is not null)
+            var condition = CheckExpressionType(cs.Condition, BuiltIns.Bool);
+            // Checked right away, since checking a block declares its variables, so it must
+            // only happen once however many times the optimizer walks the result
+            var trueBlock = new TypeChecker(this).CheckTypes(cs.TrueBlock, returnType).ToList();
+            List<TypeCheckedStatement> falseBlock = [];
+            if (cs.FalseBlock is not null)
+            {
+                falseBlock = new TypeChecker(this)
+                    .CheckTypes(cs.FalseBlock, returnType)
+                    .ToList();
+            }
+
+            return new TypeCheckedConditional
+            {
+                Condition = condition,
+                TrueBlock = trueBlock,
+                FalseBlock = falseBlock,
+            };
+        }
+        else if (node is LoopStatement ls)
+        {
+            if (!ls.Body.Any())
+            {
+                var message = "Warning: empty loop detected";
+                var lineNumber = GetLineNumber(ls);
+                if (lineNumber is not null)
                 {
-                    falseBlock = new TypeChecker(this).CheckTypes(cs.FalseBlock, returnType);
+                    message += $" on line {lineNumber}";
                 }
 
-                yield return new TypeCheckedConditional
-                {
-                    Condition = condition,
-                    TrueBlock = trueBlock,
-                    FalseBlock = falseBlock,
-                };
+                _warnings.WriteLine(message);
             }
-            else if (node is LoopStatement ls)
-            {
-                if (!ls.Body.Any())
-                {
-                    var message = "Warning: empty loop detected";
-                    var lineNumber = GetLineNumber(ls);
-                    if (lineNumber is not null)
-                    {
-                        message += $" on line {lineNumber}";
-                    }
 
-                    Console.Error.WriteLine(message);
-                }
+            ForbidClassDefinitions(ls.Body);
 
-                if (ls.Body.Any(x => x is ClassDefinition))
-                {
-                    var lineNumber = ls
-                        .Body.OfType<ClassDefinition>()
-                        .Select(x => GetLineNumber(x))
-                        .FirstOrDefault(x => x is not null);
-
-                    throw new TypeCheckException(
-                        "Conditional class definitions are forbidden",
-                        lineNumber
-                    );
-                }
+            var condition = CheckExpressionType(ls.Condition, BuiltIns.Bool);
+            var body = new TypeChecker(this).CheckTypes(ls.Body, returnType).ToList();
 
-                var condition = CheckExpressionType(ls.Condition, BuiltIns.Bool);
-                var body = new TypeChecker(this).CheckTypes(ls.Body, returnType);
+            return new TypeCheckedLoop { Condition = condition, Body = body };
+        }
+        else if (node is RangeLoopStatement rls)
+        {
+            ForbidClassDefinitions(rls.Body);
 
-                yield return new TypeCheckedLoop { Condition = condition, Body = body };
-            }
-            else if (node is FunctionDeclaration fd)
+            var start = CheckExpressionType(rls.Start, BuiltIns.Int);
+            var end = CheckExpressionType(rls.End, BuiltIns.Int);
+
+            return new TypeCheckedRangeLoop
             {
-                yield return CheckFunctionTypeSecondPass(fd);
-            }
-            else if (node is Expression e)
+                Variable = rls.Variable,
+                VariableType = BuiltIns.Int,
+                Start = start,
+                End = end,
+                Body = CheckLoopBody(rls.Variable, BuiltIns.Int, rls.Body, returnType),
+            };
+        }
+        else if (node is ArrayLoopStatement als)
+        {
+            ForbidClassDefinitions(als.Body);
+
+            var array = CheckExpressionType(als.Array, null);
+            if (!array.Type.IsInstantiationOf(BuiltIns.Array))
             {
-                yield return CheckExpressionType(e, null);
+                throw new TypeCheckException(
+                    $"Cannot iterate over {array.Type}; only arrays and ranges can be used in for loops",
+                    GetLineNumber(als)
+                );
             }
-            else
+            var elementType = array.Type.GenericTypes.Single();
+
+            return new TypeCheckedArrayLoop
             {
-                throw new ArgumentException($"Unrecognized type {node.GetType()}");
-            }
+                Variable = als.Variable,
+                VariableType = elementType,
+                Array = array,
+                Body = CheckLoopBody(als.Variable, elementType, als.Body, returnType),
+            };
+        }
+        else if (node is FunctionDeclaration fd)
+        {
+            return CheckFunctionTypeSecondPass(fd);
+        }
+        else if (node is Expression e)
+        {
+            return CheckExpressionType(e, null);
+        }
+        else
+        {
+            throw new ArgumentException($"Unrecognized type {node.GetType()}");
         }
     }
 
-    private bool VariableNameExistsInLocalScope(string name)
+    private void ForbidClassDefinitions(IEnumerable<AstNode> block)
     {
-        if (_knownVariables.Count <= _scopeStart)
+        if (block.Any(x => x is ClassDefinition))
+        {
+            var lineNumber = block
+                .OfType<ClassDefinition>()
+                .Select(x => GetLineNumber(x))
+                .FirstOrDefault(x => x is not null);
+
+            throw new TypeCheckException("Conditional class definitions are forbidden", lineNumber);
+        }
+    }
+
+    // The loop variable belongs to the body's scope, like a function's arguments.
+    private List<TypeCheckedStatement> CheckLoopBody(
+        string variable,
+        Models.Type type,
+        IEnumerable<AstNode> body,
+        Models.Type? returnType
+    )
+    {
+        var innerChecker = new TypeChecker(this);
+        innerChecker._knownVariables.Add(new Variable { Name = variable, Type = type });
+        return innerChecker.CheckTypes(body, returnType).ToList();
+    }
+
+    // Builtins that take a function call it on several threads at once, so it has to be parallel
+    // safe.
+    private CheckResult<TypeCheckedExpression> CheckFunctionReference(
+        Identifier i,
+        Models.Type functionType
+    )
+    {
+        var argumentTypes = functionType.GenericTypes.SkipLast(1).ToArray();
+        var returnType = functionType.GenericTypes.Last();
+
+        var method = _knownFunctions
+            .Lookup(i.Name)
+            .FirstOrDefault(m =>
+                m.ThisType == BuiltIns.Void
+                && m.ReturnType == returnType
+                && m.ArgumentTypes.SequenceEqual(argumentTypes)
+            );
+        if (method is null)
+        {
+            return new TypeCheckException(
+                $"No overload of {i.Name} takes ({string.Join(", ", argumentTypes.Select(t => t.ToString()))}) and returns {returnType}",
+                GetLineNumber(i)
+            );
+        }
+
+        if (!IsParallelSafe(method, []))
+        {
+            return new TypeCheckException(
+                $"{method} can't be run in parallel: it may only use numbers, Bools and Chars, and only call functions that do the same",
+                GetLineNumber(i)
+            );
+        }
+
+        return new TypeCheckedFunctionReference { Method = method, Type = functionType };
+    }
+
+    // Whether a function only computes with primitives and only calls functions that do the same.
+    // Such a function touches nothing shared, not even a reference count, so any number of threads
+    // can run it at once. This works on the syntax, since the body may not be checked yet.
+    private bool IsParallelSafe(Method method, HashSet<Method> visiting)
+    {
+        if (method.Declaration is not FunctionDeclaration fd)
         {
             return false;
         }
-        return _knownVariables[_scopeStart..].Any(v => v.Name == name);
+        // A recursive call is as safe as the rest of the function.
+        if (!visiting.Add(method))
+        {
+            return true;
+        }
+
+        return (method.ReturnType == BuiltIns.Void || IsParallelSafeType(method.ReturnType))
+            && method.ArgumentTypes.All(IsParallelSafeType)
+            && fd.Body.All(node => IsParallelSafe(node, visiting));
+    }
+
+    private static bool IsParallelSafeType(Models.Type? type) =>
+        type is not null && type != BuiltIns.Void && BuiltIns.PrimitiveTypes.Contains(type);
+
+    private bool IsParallelSafe(AstNode node, HashSet<Method> visiting) =>
+        node switch
+        {
+            VarDeclaration vd => IsParallelSafeType(TryLookupType(vd.DeclaredType).Value)
+                && IsParallelSafe(vd.Value, visiting),
+            Assignment a => a.Lhs is Identifier && IsParallelSafe(a.Rhs, visiting),
+            ConditionalStatement cs => IsParallelSafe(cs.Condition, visiting)
+                && cs.TrueBlock.Concat(cs.FalseBlock ?? []).All(n => IsParallelSafe(n, visiting)),
+            LoopStatement ls => IsParallelSafe(ls.Condition, visiting)
+                && ls.Body.All(n => IsParallelSafe(n, visiting)),
+            RangeLoopStatement rls => IsParallelSafe(rls.Start, visiting)
+                && IsParallelSafe(rls.End, visiting)
+                && rls.Body.All(n => IsParallelSafe(n, visiting)),
+            ReturnStatement rs => rs.Value is null || IsParallelSafe(rs.Value, visiting),
+            IntegerLiteral or DecimalLiteral or BooleanLiteral or CharLiteral or Identifier => true,
+            BinaryExpression be => be.Operator != "??"
+                && IsParallelSafe(be.Lhs, visiting)
+                && IsParallelSafe(be.Rhs, visiting),
+            PrefixExpression pe => IsParallelSafe(pe.Operand, visiting),
+            CastExpression ce => IsParallelSafeType(TryLookupType(ce.DeclaredType).Value)
+                && IsParallelSafe(ce.Value, visiting),
+            // Which overload is called isn't known yet, so all of them must be safe.
+            FunctionCall fc => fc.Arguments.All(a => IsParallelSafe(a, visiting))
+                && _knownFunctions
+                    .Lookup(fc.Function)
+                    .Where(m => m.ArgumentTypes.Length == fc.Arguments.Count())
+                    .All(m => IsParallelSafe(m, visiting)),
+            _ => false,
+        };
+
+    private CheckResult<TypeCheckedExpression> CheckAwait(
+        AwaitExpression ae,
+        Models.Type? expectedType
+    )
+    {
+        if (_awaitContext == AwaitContext.None)
+        {
+            return new TypeCheckException(
+                "await can only be used at the top level or in an async function",
+                GetLineNumber(ae)
+            );
+        }
+
+        // The expected type picks between overloads that differ only in what their task produces.
+        if (expectedType is not null)
+        {
+            var exact = TryCheckExpressionType(
+                ae.Operand,
+                BuiltIns.Task.Instantiate([expectedType])
+            );
+            if (exact.Value is not null)
+            {
+                return new TypeCheckedAwait { Operand = exact.Value };
+            }
+        }
+
+        var result = TryCheckExpressionType(ae.Operand, null);
+        if (result.Value is not TypeCheckedExpression operand)
+        {
+            return result.Error!;
+        }
+        if (!operand.Type.IsInstantiationOf(BuiltIns.Task))
+        {
+            return new TypeCheckException(
+                $"Only a Task can be awaited, not {operand.Type}",
+                GetLineNumber(ae)
+            );
+        }
+
+        TypeCheckedExpression awaited = new TypeCheckedAwait { Operand = operand };
+        if (expectedType is not null && !expectedType.IsImplicitlyConvertibleFrom(awaited.Type))
+        {
+            return new TypeCheckException(
+                $"Awaiting {operand.Type} gives {awaited.Type}, not {expectedType}",
+                GetLineNumber(ae)
+            );
+        }
+        return new(awaited, null);
     }
 
-    private void CheckFunctionTypeFirstPass(FunctionDeclaration fd)
+    private static bool ContainsAwait(Expression expr) =>
+        expr switch
+        {
+            AwaitExpression => true,
+            BinaryExpression be => ContainsAwait(be.Lhs) || ContainsAwait(be.Rhs),
+            PrefixExpression pe => ContainsAwait(pe.Operand),
+            FunctionCall fc => fc.Arguments.Any(ContainsAwait),
+            ConstructorCall cc => cc.Arguments.Any(ContainsAwait),
+            MemberAccessExpression ma => ContainsAwait(ma.Base) || ContainsAwait(ma.Member),
+            IndexExpression ie => ContainsAwait(ie.Base) || ContainsAwait(ie.Index),
+            CastExpression ce => ContainsAwait(ce.Value),
+            ArrayLiteral al => al.Values.Any(ContainsAwait),
+            StringInterpolation si => si.Pieces.Any(ContainsAwait),
+            _ => false,
+        };
+
+    private Method CheckFunctionTypeFirstPass(FunctionDeclaration fd)
     {
         var argumentNames = new HashSet<string>();
         foreach (var arg in fd.Arguments)
@@ -275,11 +529,11 @@ public class TypeChecker
         {
             Name = fd.Name,
             ArgumentTypes = argumentTypes,
-            ReturnType = returnType,
+            ReturnType = fd.Async ? BuiltIns.Task.Instantiate([returnType]) : returnType,
             Declaration = fd,
         };
 
-        var overlaps = _knownFunctions.Where(m => m.OverlapsWith(method));
+        var overlaps = _knownFunctions.Lookup(method.Name).Where(m => m.OverlapsWith(method));
         if (overlaps.Any())
         {
             throw new TypeCheckException(
@@ -289,22 +543,28 @@ public class TypeChecker
         }
 
         _knownFunctions.Add(method);
+        _declaredFunctions.Add(fd, method);
+        return method;
     }
 
     private TypeCheckedFunctionDeclaration CheckFunctionTypeSecondPass(FunctionDeclaration fd)
     {
-        var method = _knownFunctions.Single(m => object.ReferenceEquals(fd, m.Declaration));
+        var method = _declaredFunctions[fd];
+        // The body of an async function returns what awaiting it produces.
+        var returnType = fd.Async ? method.ReturnType.GenericTypes.Single() : method.ReturnType;
 
-        var innerChecker = new TypeChecker(this);
-        innerChecker._knownVariables.AddRange(
-            Enumerable
-                .Zip(fd.Arguments, method.ArgumentTypes)
-                .Select(t => new Variable { Name = t.Item1.Name, Type = t.Item2 })
-        );
+        var innerChecker = new TypeChecker(this)
+        {
+            _awaitContext = fd.Async ? AwaitContext.AsyncFunction : AwaitContext.None,
+        };
+        foreach (var (argument, type) in Enumerable.Zip(fd.Arguments, method.ArgumentTypes))
+        {
+            innerChecker._knownVariables.Add(new Variable { Name = argument.Name, Type = type });
+        }
 
-        var body = innerChecker.CheckTypes(fd.Body, method.ReturnType).ToList();
+        var body = innerChecker.CheckTypes(fd.Body, returnType).ToList();
 
-        if (method.ReturnType != BuiltIns.Void && !body.Any(x => x.IsReturn))
+        if (returnType != BuiltIns.Void && !body.Any(x => x.IsReturn))
         {
             throw new TypeCheckException(
                 "Non-Void function must have a return statement",
@@ -315,6 +575,7 @@ public class TypeChecker
         return new()
         {
             Method = method,
+            IsAsync = fd.Async,
             Body = body,
             Arguments = Enumerable
                 .Zip(fd.Arguments, method.ArgumentTypes)
@@ -326,34 +587,43 @@ public class TypeChecker
         };
     }
 
-    private static TReturn ExpectOneSuccess<TOption, TReturn>(
+    // Tries each overload, expecting exactly one of them to type-check. Most candidates fail, so
+    // failures are returned rather than thrown.
+    private static CheckResult<TypeCheckedExpression> ExpectOneSuccess<TOption>(
         IEnumerable<TOption> options,
-        Func<TOption, TReturn> transform
+        Func<TOption, CheckResult<TypeCheckedExpression>> transform
     )
         where TOption : notnull
     {
-        var exceptions = new List<Exception>();
-        var successes = new List<(TOption, TReturn)>();
+        var errors = new List<TypeCheckException>();
+        var successes = new List<(TOption, TypeCheckedExpression)>();
         foreach (var opt in options)
         {
-            try
+            var result = transform(opt);
+            if (result.Value is not null)
             {
-                successes.Add((opt, transform(opt)));
+                successes.Add((opt, result.Value));
             }
-            catch (Exception e)
+            else
             {
-                exceptions.Add(e);
+                errors.Add(result.Error!);
             }
         }
 
         switch (successes.Count)
         {
             case 0:
-                throw new AggregateException(exceptions);
+                if (errors.Count == 1)
+                {
+                    return errors[0];
+                }
+                return new TypeCheckException(
+                    string.Join("; ", errors.Select(e => e.Message).Distinct())
+                );
             case 1:
-                return successes[0].Item2;
+                return new(successes[0].Item2, null);
             default:
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Multiple matches found: "
                         + string.Join(", ", successes.Select(s => s.Item1.ToString()))
                 );
@@ -361,16 +631,60 @@ public class TypeChecker
     }
 
     public TypeCheckedExpression CheckExpressionType(Expression expr, Models.Type? expectedType)
+    {
+        var result = TryCheckExpressionType(expr, expectedType);
+        return result.Value ?? throw result.Error!;
+    }
+
+    // Overload resolution checks the same subexpressions against the same types many times over,
+    // once for each candidate of every enclosing call or operator. Remembering each result keeps
+    // type checking linear in the size of an expression rather than exponential in its depth.
+    private CheckResult<TypeCheckedExpression> TryCheckExpressionType(
+        Expression expr,
+        Models.Type? expectedType
+    )
+    {
+        if (!_checkedExpressions.TryGetValue((expr, expectedType), out var result))
+        {
+            result = CheckExpressionTypeUncached(expr, expectedType);
+            _checkedExpressions.Add((expr, expectedType), result);
+        }
+        return result;
+    }
+
+    // Checks each expression against the type at the same position, stopping at the first failure.
+    private CheckResult<List<TypeCheckedExpression>> TryCheckAll(
+        IEnumerable<Expression> expressions,
+        IEnumerable<Models.Type?> expectedTypes
+    )
+    {
+        var results = new List<TypeCheckedExpression>();
+        foreach (var (expr, expectedType) in expressions.Zip(expectedTypes))
+        {
+            var result = TryCheckExpressionType(expr, expectedType);
+            if (result.Value is null)
+            {
+                return result.Error!;
+            }
+            results.Add(result.Value);
+        }
+        return results;
+    }
+
+    private CheckResult<TypeCheckedExpression> CheckExpressionTypeUncached(
+        Expression expr,
+        Models.Type? expectedType
+    )
     {
         if (expr is FunctionCall fc)
         {
-            var candidateFunctions = _knownFunctions.Where(f =>
-                f.ThisType == BuiltIns.Void && f.Name == fc.Function
-            );
+            var candidateFunctions = _knownFunctions
+                .Lookup(fc.Function)
+                .Where(f => f.ThisType == BuiltIns.Void);
 
             if (!candidateFunctions.Any())
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"No known functions match name {fc.Function}",
                     GetLineNumber(fc)
                 );
@@ -384,7 +698,7 @@ public class TypeChecker
 
                 if (!candidateFunctions.Any())
                 {
-                    throw new TypeCheckException(
+                    return new TypeCheckException(
                         $"No overloads of {fc.Function} return {expectedType}",
                         GetLineNumber(fc)
                     );
@@ -396,7 +710,7 @@ public class TypeChecker
             );
             if (!candidateFunctions.Any())
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"No overloads of {fc.Function} take {fc.Arguments.Count()} arguments",
                     GetLineNumber(fc)
                 );
@@ -406,25 +720,26 @@ public class TypeChecker
                 candidateFunctions,
                 (f) =>
                 {
-                    var arguments = Enumerable
-                        .Zip(fc.Arguments, f.ArgumentTypes)
-                        .Select(t => CheckExpressionType(t.Item1, t.Item2));
-                    return new TypeCheckedFunctionCall { Method = f, Arguments = arguments };
+                    var arguments = TryCheckAll(fc.Arguments, f.ArgumentTypes);
+                    if (arguments.Value is null)
+                    {
+                        return arguments.Error!;
+                    }
+                    return new TypeCheckedFunctionCall { Method = f, Arguments = arguments.Value };
                 }
             );
         }
         else if (expr is ConstructorCall cc)
         {
-            var targetType =
-                LookupType(cc.Target)
-                ?? throw new TypeCheckException(
-                    $"Unrecognized type {cc.Target}",
-                    GetLineNumber(cc)
-                );
+            var targetResult = TryLookupType(cc.Target);
+            if (targetResult.Value is not Models.Type targetType)
+            {
+                return targetResult.Error!;
+            }
 
             if (expectedType is not null && !expectedType.IsImplicitlyConvertibleFrom(targetType))
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"Cannot convert constructor call on {cc.Target} to type {expectedType}",
                     GetLineNumber(cc)
                 );
@@ -435,7 +750,7 @@ public class TypeChecker
             );
             if (!constructorCandidates.Any())
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"{cc.Target} has no constructors that take {cc.Arguments.Count()} arguments"
                 );
             }
@@ -444,10 +759,12 @@ public class TypeChecker
                 constructorCandidates,
                 c =>
                 {
-                    var arguments = Enumerable
-                        .Zip(cc.Arguments, c.ArgumentTypes)
-                        .Select(t => CheckExpressionType(t.Item1, t.Item2));
-                    return new TypeCheckedFunctionCall { Method = c, Arguments = arguments };
+                    var arguments = TryCheckAll(cc.Arguments, c.ArgumentTypes);
+                    if (arguments.Value is null)
+                    {
+                        return arguments.Error!;
+                    }
+                    return new TypeCheckedFunctionCall { Method = c, Arguments = arguments.Value };
                 }
             );
         }
@@ -457,7 +774,7 @@ public class TypeChecker
             {
                 if (double.IsFinite(dl.Value) && Math.Abs(dl.Value) > (double)float.MaxValue)
                 {
-                    throw new TypeCheckException(
+                    return new TypeCheckException(
                         $"Decimal literal is too large to store as Float",
                         GetLineNumber(dl)
                     );
@@ -468,7 +785,7 @@ public class TypeChecker
                 && !expectedType.IsImplicitlyConvertibleFrom(BuiltIns.Double)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"{expectedType} cannot be expressed by decimal literal",
                     GetLineNumber(dl)
                 );
@@ -486,15 +803,28 @@ public class TypeChecker
                 expectedType is not null
                 && expectedType != BuiltIns.Float
                 && expectedType != BuiltIns.Double
+                && !BuiltIns.SizedIntegerRanges.ContainsKey(expectedType)
                 && !expectedType.IsImplicitlyConvertibleFrom(BuiltIns.Int)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"{expectedType} cannot be expressed by integer literal",
                     GetLineNumber(il)
                 );
             }
 
+            if (
+                expectedType is not null
+                && BuiltIns.SizedIntegerRanges.TryGetValue(expectedType, out var range)
+                && (il.Value < range.Min || il.Value > range.Max)
+            )
+            {
+                return new TypeCheckException(
+                    $"Integer literal {il.Value} is out of range for {expectedType}",
+                    GetLineNumber(il)
+                );
+            }
+
             return new TypedIntegerLiteral
             {
                 Value = il.Value,
@@ -508,16 +838,19 @@ public class TypeChecker
                 && !expectedType.IsImplicitlyConvertibleFrom(BuiltIns.String)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Only String instances can be represented by string interpolations",
                     GetLineNumber(si)
                 );
             }
 
-            return new TypeCheckedStringInterpolation
+            var pieces = TryCheckAll(si.Pieces, si.Pieces.Select(_ => (Models.Type?)null));
+            if (pieces.Value is null)
             {
-                Pieces = si.Pieces.Select(e => CheckExpressionType(e, null)),
-            };
+                return pieces.Error!;
+            }
+
+            return new TypeCheckedStringInterpolation { Pieces = pieces.Value };
         }
         else if (expr is StringLiteral sl)
         {
@@ -526,7 +859,7 @@ public class TypeChecker
                 && !expectedType.IsImplicitlyConvertibleFrom(BuiltIns.String)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Only String instances can be represented by string literals",
                     GetLineNumber(sl)
                 );
@@ -536,9 +869,23 @@ public class TypeChecker
         }
         else if (expr is BinaryExpression be)
         {
-            var ops = BuiltIns.Operators.Where(op =>
-                op.Fixity == OperatorFixity.Infix && op.Name == be.Operator
-            );
+            // The right-hand side of ?? is compiled into a lambda, which can't suspend the async
+            // function around it.
+            if (
+                _awaitContext == AwaitContext.AsyncFunction
+                && be.Operator == "??"
+                && ContainsAwait(be.Rhs)
+            )
+            {
+                return new TypeCheckException(
+                    "await can't be used on the right of ?? in an async function; await into a variable first",
+                    GetLineNumber(be)
+                );
+            }
+
+            IEnumerable<Operator> ops = BuiltIns.OperatorsBySymbol[
+                (be.Operator, OperatorFixity.Infix)
+            ];
 
             if (expectedType is not null)
             {
@@ -562,7 +909,7 @@ public class TypeChecker
 
                 if (!ops.Any())
                 {
-                    throw new TypeCheckException(
+                    return new TypeCheckException(
                         $"Operator {be.Operator} cannot produce {expectedType}",
                         GetLineNumber(be)
                     );
@@ -573,30 +920,36 @@ public class TypeChecker
                 ops,
                 (op) =>
                 {
-                    TypeCheckedExpression lhs,
-                        rhs;
-                    if (op.GenericTypes.All(t => t.IsFullyInstantiated()))
+                    // Operands whose types depend on uninstantiated generics are checked
+                    // without an expected type, and the generics are derived from them instead.
+                    var isGeneric = !op.GenericTypes.All(t => t.IsFullyInstantiated());
+
+                    var lhsResult = TryCheckExpressionType(
+                        be.Lhs,
+                        isGeneric && !op.LhsType!.IsFullyInstantiated() ? null : op.LhsType
+                    );
+                    if (lhsResult.Value is not TypeCheckedExpression lhs)
                     {
-                        lhs = CheckExpressionType(be.Lhs, op.LhsType);
-                        rhs = CheckExpressionType(be.Rhs, op.RhsType);
+                        return lhsResult.Error!;
                     }
-                    else
+
+                    var rhsResult = TryCheckExpressionType(
+                        be.Rhs,
+                        isGeneric && !op.RhsType!.IsFullyInstantiated() ? null : op.RhsType
+                    );
+                    if (rhsResult.Value is not TypeCheckedExpression rhs)
                     {
-                        lhs = CheckExpressionType(
-                            be.Lhs,
-                            op.LhsType!.IsFullyInstantiated() ? op.LhsType : null
-                        );
-                        rhs = CheckExpressionType(
-                            be.Rhs,
-                            op.RhsType!.IsFullyInstantiated() ? op.RhsType : null
-                        );
+                        return rhsResult.Error!;
+                    }
 
-                        var derivedInstantiation = op.LhsType.DeriveInstantiation(lhs.Type);
-                        var di2 = op.RhsType.DeriveInstantiation(rhs.Type);
+                    if (isGeneric)
+                    {
+                        var derivedInstantiation = op.LhsType!.DeriveInstantiation(lhs.Type);
+                        var di2 = op.RhsType!.DeriveInstantiation(rhs.Type);
 
                         if (derivedInstantiation is null || di2 is null)
                         {
-                            throw new TypeCheckException(
+                            return new TypeCheckException(
                                 $"Unable to determine generic type for operator {op.Name}",
                                 GetLineNumber(be)
                             );
@@ -608,7 +961,7 @@ public class TypeChecker
                             {
                                 if (value != kvp.Value)
                                 {
-                                    throw new TypeCheckException(
+                                    return new TypeCheckException(
                                         $"Unable to determine generic type for operator {op.Name}",
                                         GetLineNumber(be)
                                     );
@@ -634,19 +987,26 @@ public class TypeChecker
         }
         else if (expr is Identifier i)
         {
-            var variable =
-                _knownVariables.LastOrDefault(v => v.Name == i.Name)
-                ?? throw new TypeCheckException(
+            if (expectedType is not null && BuiltIns.IsFunctionType(expectedType))
+            {
+                return CheckFunctionReference(i, expectedType);
+            }
+
+            var variable = _knownVariables.Find(i.Name);
+            if (variable is null)
+            {
+                return new TypeCheckException(
                     $"Unrecognized identifier {i.Name}",
                     GetLineNumber(i)
                 );
+            }
 
             if (
                 expectedType is not null
                 && !expectedType.IsImplicitlyConvertibleFrom(variable.Type)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"Type mismatch: {variable.Name} is {variable.Type}; expected {expectedType}",
                     GetLineNumber(i)
                 );
@@ -661,7 +1021,7 @@ public class TypeChecker
                 && !expectedType.IsImplicitlyConvertibleFrom(BuiltIns.Bool)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Only Bool instances can be represented by boolean literals",
                     GetLineNumber(bl)
                 );
@@ -669,11 +1029,15 @@ public class TypeChecker
 
             return new TypeCheckedBooleanLiteral { Value = bl.Value };
         }
+        else if (expr is AwaitExpression ae)
+        {
+            return CheckAwait(ae, expectedType);
+        }
         else if (expr is PrefixExpression pe)
         {
-            var ops = BuiltIns.Operators.Where(op =>
-                op.Fixity == OperatorFixity.Prefix && op.Name == pe.Operator
-            );
+            IEnumerable<Operator> ops = BuiltIns.OperatorsBySymbol[
+                (pe.Operator, OperatorFixity.Prefix)
+            ];
 
             if (expectedType is not null)
             {
@@ -681,7 +1045,7 @@ public class TypeChecker
 
                 if (!ops.Any())
                 {
-                    throw new TypeCheckException(
+                    return new TypeCheckException(
                         $"Operator {pe.Operator} cannot produce {expectedType}",
                         GetLineNumber(pe)
                     );
@@ -692,56 +1056,66 @@ public class TypeChecker
                 ops,
                 (op) =>
                 {
-                    var rhs = CheckExpressionType(pe.Operand, op.RhsType);
+                    var rhs = TryCheckExpressionType(pe.Operand, op.RhsType);
+                    if (rhs.Value is null)
+                    {
+                        return rhs.Error!;
+                    }
                     return new TypeCheckedOperatorCall
                     {
                         Operator = op,
                         Lhs = null,
-                        Rhs = rhs,
+                        Rhs = rhs.Value,
                     };
                 }
             );
         }
         else if (expr is CastExpression ce)
         {
-            var targetType =
-                LookupType(ce.DeclaredType)
-                ?? throw new TypeCheckException(
-                    $"Unrecognized type {ce.DeclaredType}",
-                    GetLineNumber(ce)
-                );
+            var targetResult = TryLookupType(ce.DeclaredType);
+            if (targetResult.Value is not Models.Type targetType)
+            {
+                return targetResult.Error!;
+            }
 
             if (expectedType is not null && expectedType != targetType)
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"Cast type {ce.DeclaredType} does not match expected type {expectedType}",
                     GetLineNumber(ce)
                 );
             }
 
-            try
+            var typedResult = TryCheckExpressionType(ce.Value, targetType);
+            if (typedResult.Value is not null)
             {
-                return CheckExpressionType(ce.Value, targetType);
+                return typedResult;
             }
-            catch
+
+            var untypedResult = TryCheckExpressionType(ce.Value, null);
+            if (untypedResult.Value is not TypeCheckedExpression untyped)
             {
-                var untypedResult = CheckExpressionType(ce.Value, null);
-                if (!targetType.IsCastableFrom(untypedResult.Type))
-                {
-                    throw new TypeCheckException(
-                        $"{untypedResult.Type} is not castable to {targetType}",
-                        GetLineNumber(ce)
-                    );
-                }
-                return new TypeCheckedCastExpression { Base = untypedResult, Type = targetType };
+                return untypedResult.Error!;
+            }
+            if (!targetType.IsCastableFrom(untyped.Type))
+            {
+                return new TypeCheckException(
+                    $"{untyped.Type} is not castable to {targetType}",
+                    GetLineNumber(ce)
+                );
             }
+            return new TypeCheckedCastExpression { Base = untyped, Type = targetType };
         }
         else if (expr is IndexExpression ie)
         {
-            var base_ = CheckExpressionType(ie.Base, null);
+            var baseResult = TryCheckExpressionType(ie.Base, null);
+            if (baseResult.Value is not TypeCheckedExpression base_)
+            {
+                return baseResult.Error!;
+            }
             if (base_.Type.Subscript is null)
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"Type {base_.Type} has no subscript",
                     GetLineNumber(ie)
                 );
@@ -752,53 +1126,58 @@ public class TypeChecker
                 && !expectedType.IsImplicitlyConvertibleFrom(base_.Type.Subscript.ReturnType)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     $"Subscript on {base_.Type} returns {base_.Type.Subscript.ReturnType}, not {expectedType}",
                     GetLineNumber(ie)
                 );
             }
 
-            var index = CheckExpressionType(ie.Index, base_.Type.Subscript.IndexType);
+            var index = TryCheckExpressionType(ie.Index, base_.Type.Subscript.IndexType);
+            if (index.Value is null)
+            {
+                return index.Error!;
+            }
 
-            return new TypeCheckedIndexAccess { Base = base_, Index = index };
+            return new TypeCheckedIndexAccess { Base = base_, Index = index.Value };
         }
         else if (expr is ArrayLiteral al)
         {
             if (expectedType is null)
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Array literals must have an explicit type",
                     GetLineNumber(al)
                 );
             }
             if (!expectedType.IsInstantiationOf(BuiltIns.Array))
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Only Arrays can be represented by array literals",
                     GetLineNumber(al)
                 );
             }
 
-            return new TypeCheckedArrayLiteral
+            var elementType = expectedType.GenericTypes.Single();
+            var values = TryCheckAll(al.Values, al.Values.Select(_ => elementType));
+            if (values.Value is null)
             {
-                Type = expectedType,
-                Values = al.Values.Select(el =>
-                    CheckExpressionType(el, expectedType.GenericTypes.Single())
-                ),
-            };
+                return values.Error!;
+            }
+
+            return new TypeCheckedArrayLiteral { Type = expectedType, Values = values.Value };
         }
         else if (expr is NullLiteral nl)
         {
             if (expectedType is null)
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Null literals must have an explicit type",
                     GetLineNumber(nl)
                 );
             }
             if (!expectedType.IsInstantiationOf(BuiltIns.Optional))
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Only Optionals can be represented by null literals",
                     GetLineNumber(nl)
                 );
@@ -813,7 +1192,7 @@ public class TypeChecker
                 && !expectedType.IsImplicitlyConvertibleFrom(BuiltIns.Char)
             )
             {
-                throw new TypeCheckException(
+                return new TypeCheckException(
                     "Only Char instances can be represented by character literals",
                     GetLineNumber(cl)
                 );
@@ -823,22 +1202,29 @@ public class TypeChecker
         }
         else if (expr is MemberAccessExpression mae)
         {
-            var base_ = CheckExpressionType(mae.Base, null);
+            var baseResult = TryCheckExpressionType(mae.Base, null);
+            if (baseResult.Value is not TypeCheckedExpression base_)
+            {
+                return baseResult.Error!;
+            }
+
             if (mae.Member is Identifier i0)
             {
-                var prop =
-                    base_.Type.Properties.SingleOrDefault(p => p.Name == i0.Name)
-                    ?? throw new TypeCheckException(
+                var prop = base_.Type.Properties.SingleOrDefault(p => p.Name == i0.Name);
+                if (prop is null)
+                {
+                    return new TypeCheckException(
                         $"Type {base_.Type} has no member {i0.Name}",
                         GetLineNumber(i0)
                     );
+                }
 
                 if (
                     expectedType is not null
                     && !expectedType.IsImplicitlyConvertibleFrom(prop.Type)
                 )
                 {
-                    throw new TypeCheckException(
+                    return new TypeCheckException(
                         $"{base_.Type}.{prop.Name} is of type {prop.Type} ({expectedType} expected)",
                         GetLineNumber(i0)
                     );
@@ -854,7 +1240,7 @@ public class TypeChecker
 
                 if (!methods.Any())
                 {
-                    throw new TypeCheckException(
+                    return new TypeCheckException(
                         $"Type {base_.Type} has no method named {fc0.Function}",
                         GetLineNumber(fc0)
                     );
@@ -868,7 +1254,7 @@ public class TypeChecker
 
                     if (!methods.Any())
                     {
-                        throw new TypeCheckException(
+                        return new TypeCheckException(
                             $"Method {base_.Type}.{fc0.Function} has no overloads that return {expectedType}",
                             GetLineNumber(fc0)
                         );
@@ -876,19 +1262,28 @@ public class TypeChecker
                 }
 
                 methods = methods.Where(m => m.ArgumentTypes.Length == fc0.Arguments.Count());
+                if (!methods.Any())
+                {
+                    return new TypeCheckException(
+                        $"Method {base_.Type}.{fc0.Function} has no overloads that take {fc0.Arguments.Count()} arguments",
+                        GetLineNumber(fc0)
+                    );
+                }
 
                 return ExpectOneSuccess(
                     methods,
                     m =>
                     {
-                        var arguments = Enumerable
-                            .Zip(fc0.Arguments, m.ArgumentTypes)
-                            .Select(t => CheckExpressionType(t.Item1, t.Item2));
+                        var arguments = TryCheckAll(fc0.Arguments, m.ArgumentTypes);
+                        if (arguments.Value is null)
+                        {
+                            return arguments.Error!;
+                        }
                         return new TypeCheckedMethodCall
                         {
                             Base = base_,
                             Method = m,
-                            Arguments = arguments,
+                            Arguments = arguments.Value,
                         };
                     }
                 );
@@ -935,31 +1330,48 @@ public class TypeChecker
         _knownTypes.Add(thisType);
 
         // TODO: add variables declared in here to thisType.Properties
-        var body = new TypeChecker(this).CheckTypes(cd.Body);
+        var body = new TypeChecker(this).CheckTypes(cd.Body).ToList();
 
         return new() { Type = thisType, Body = body };
     }
 
     public Models.Type? LookupType(AstType type)
     {
-        var found = _knownTypes.SingleOrDefault(t => t.Name == type.Name);
-        if (found is null)
+        if (!_knownTypes.Lookup(type.Name).Any())
         {
             return null;
         }
+        var result = TryLookupType(type);
+        return result.Value ?? throw result.Error!;
+    }
+
+    // Like LookupType, but returns what is wrong with the type rather than throwing it, for use
+    // while checking expressions.
+    private CheckResult<Models.Type> TryLookupType(AstType type)
+    {
+        var found = _knownTypes.Lookup(type.Name).SingleOrDefault();
+        if (found is null)
+        {
+            return new TypeCheckException($"Unrecognized type {type}", GetLineNumber(type));
+        }
 
         if (type.Arguments.Any())
         {
-            return found.Instantiate(
-                type.Arguments.Select(t =>
-                    LookupType(t)
-                    ?? throw new TypeCheckException($"Unrecognized type {t}", GetLineNumber(type))
-                )
-            );
+            var arguments = new List<Models.Type>();
+            foreach (var argument in type.Arguments)
+            {
+                var result = TryLookupType(argument);
+                if (result.Value is null)
+                {
+                    return result;
+                }
+                arguments.Add(result.Value);
+            }
+            return found.Instantiate(arguments);
         }
         else if (found.GenericTypes.Count > 0)
         {
-            throw new TypeCheckException(
+            return new TypeCheckException(
                 $"Missing generic type arguments for type {type.Name}",
                 GetLineNumber(type)
             );
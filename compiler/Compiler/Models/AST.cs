@@ -54,6 +54,25 @@ public class LoopStatement : AstNode
     public Location? Loc { get; set; }
 }
 
+public class RangeLoopStatement : AstNode
+{
+    public string Type { get; set; }
+    public string Variable { get; set; }
+    public Expression Start { get; set; }
+    public Expression End { get; set; }
+    public IEnumerable<AstNode> Body { get; set; }
+    public Location? Loc { get; set; }
+}
+
+public class ArrayLoopStatement : AstNode
+{
+    public string Type { get; set; }
+    public string Variable { get; set; }
+    public Expression Array { get; set; }
+    public IEnumerable<AstNode> Body { get; set; }
+    public Location? Loc { get; set; }
+}
+
 [JsonConverter(typeof(AstJsonConverter))]
 public interface Declaration : AstNode
 {
@@ -92,6 +111,7 @@ public class FunctionDeclaration : Declaration
     public AstType? ReturnType { get; set; }
     public IEnumerable<FunctionArgument> Arguments { get; set; }
     public IEnumerable<AstNode> Body { get; set; }
+    public bool Async { get; set; }
     public Location? Loc { get; set; }
 }
 
@@ -235,6 +255,13 @@ public class CharLiteral : Expression
     public Location? Loc { get; set; }
 }
 
+public class AwaitExpression : Expression
+{
+    public string Type { get; set; }
+    public Expression Operand { get; set; }
+    public Location? Loc { get; set; }
+}
+
 public class ConstructorCall : Expression
 {
     public string Type { get; set; }
@@ -18,15 +18,37 @@ public static class BuiltIns
     public static readonly Type Bool = new() { Name = "Bool", IsObject = false };
     public static readonly Type Char = new() { Name = "Char", IsObject = false };
 
-    public static readonly IReadOnlySet<Type> PrimitiveTypes = new HashSet<Type>
-    {
-        Int,
-        Double,
-        Float,
-        Bool,
-        Char,
-        Void,
-    };
+    public static readonly Type Int8 = new() { Name = "Int8", IsObject = false };
+    public static readonly Type Int16 = new() { Name = "Int16", IsObject = false };
+    public static readonly Type Int32 = new() { Name = "Int32", IsObject = false };
+    public static readonly Type Int64 = new() { Name = "Int64", IsObject = false };
+    public static readonly Type UInt8 = new() { Name = "UInt8", IsObject = false };
+    public static readonly Type UInt16 = new() { Name = "UInt16", IsObject = false };
+    public static readonly Type UInt32 = new() { Name = "UInt32", IsObject = false };
+    public static readonly Type UInt64 = new() { Name = "UInt64", IsObject = false };
+
+    // Fixed-width integers, with the values their literals may take. UInt64 literals are limited to
+    // what the AST can hold.
+    public static readonly IReadOnlyDictionary<Type, (long Min, long Max)> SizedIntegerRanges =
+        new Dictionary<Type, (long, long)>
+        {
+            { Int8, (sbyte.MinValue, sbyte.MaxValue) },
+            { Int16, (short.MinValue, short.MaxValue) },
+            { Int32, (int.MinValue, int.MaxValue) },
+            { Int64, (long.MinValue, long.MaxValue) },
+            { UInt8, (byte.MinValue, byte.MaxValue) },
+            { UInt16, (ushort.MinValue, ushort.MaxValue) },
+            { UInt32, (uint.MinValue, uint.MaxValue) },
+            { UInt64, (0L, long.MaxValue) },
+        };
+
+    public static readonly IReadOnlySet<Type> IntegerTypes = new HashSet<Type>(
+        [Int, .. SizedIntegerRanges.Keys]
+    );
+
+    public static readonly IReadOnlySet<Type> PrimitiveTypes = new HashSet<Type>(
+        [Int, Double, Float, Bool, Char, Void, .. SizedIntegerRanges.Keys]
+    );
 
     public static readonly Type String = new()
     {
@@ -46,6 +68,70 @@ public static class BuiltIns
         Subscript = new() { ReturnType = Char, IsSettable = false },
     };
 
+    private static readonly IReadOnlyCollection<Method> StringSearchMethods =
+    [
+        new()
+        {
+            Name = "find",
+            ArgumentTypes = [String],
+            ReturnType = Int,
+        },
+        new()
+        {
+            Name = "find",
+            ArgumentTypes = [Char],
+            ReturnType = Int,
+        },
+        new()
+        {
+            Name = "contains",
+            ArgumentTypes = [String],
+            ReturnType = Bool,
+        },
+        new()
+        {
+            Name = "contains",
+            ArgumentTypes = [Char],
+            ReturnType = Bool,
+        },
+        new()
+        {
+            Name = "startsWith",
+            ArgumentTypes = [String],
+            ReturnType = Bool,
+        },
+        new()
+        {
+            Name = "endsWith",
+            ArgumentTypes = [String],
+            ReturnType = Bool,
+        },
+        new()
+        {
+            Name = "count",
+            ArgumentTypes = [String],
+            ReturnType = Int,
+        },
+        new()
+        {
+            Name = "count",
+            ArgumentTypes = [Char],
+            ReturnType = Int,
+        },
+        new()
+        {
+            Name = "compare",
+            ArgumentTypes = [String],
+            ReturnType = Int,
+        },
+        new()
+        {
+            Name = "substring",
+            ArgumentTypes = [Int, Int],
+            ReturnType = String,
+        },
+    ];
+
     public static readonly Type StringBuilder = new() { Name = "StringBuilder", IsObject = false };
 
     private static readonly Type ArrayGenericPlaceholder = new()
@@ -94,9 +180,39 @@ public static class BuiltIns
         IsObject = false,
     };
 
+    private static readonly Type TaskGenericPlaceholder = new()
+    {
+        Name = "_T2",
+        IsGenericPlaceholder = true,
+    };
+
+    // What an async function returns: a handle to its result, which `await` waits for. The function
+    // runs as soon as it's called, until it first has to wait.
+    public static readonly Type Task = new()
+    {
+        Name = "Task",
+        GenericTypes = [TaskGenericPlaceholder],
+        IsObject = false,
+    };
+
+    public static readonly Type LineIterator = new()
+    {
+        Name = "LineIterator",
+        Methods = [new() { Name = "next", ReturnType = Optional.Instantiate([String]) }],
+        IsObject = false,
+    };
+
     public static readonly IReadOnlyCollection<Type> Types =
     [
         Int,
+        Int8,
+        Int16,
+        Int32,
+        Int64,
+        UInt8,
+        UInt16,
+        UInt32,
+        UInt64,
         Bool,
         Double,
         Float,
@@ -106,8 +222,22 @@ public static class BuiltIns
         StringBuilder,
         Array,
         Optional,
+        Task,
+        LineIterator,
     ];
 
+    // The type of a function passed to a builtin: its argument types, then its return type. Programs
+    // can't spell these; a function's name is converted where a builtin expects one.
+    public static Type FunctionType(Type returnType, params Type[] argumentTypes) =>
+        new()
+        {
+            Name = "Function",
+            GenericTypes = [.. argumentTypes, returnType],
+            IsObject = false,
+        };
+
+    public static bool IsFunctionType(Type t) => t.Name == "Function" && t.GenericTypes.Count > 0;
+
     public static readonly IReadOnlyCollection<Method> Methods =
     [
         new Method
@@ -116,8 +246,84 @@ public static class BuiltIns
             ArgumentTypes = [String],
             ReturnType = Void,
         },
+        new Method
+        {
+            Name = "parseInt",
+            ArgumentTypes = [String],
+            ReturnType = Optional.Instantiate([Int]),
+        },
+        new Method
+        {
+            Name = "parseDouble",
+            ArgumentTypes = [String],
+            ReturnType = Optional.Instantiate([Double]),
+        },
+        new Method
+        {
+            Name = "readLine",
+            ArgumentTypes = [],
+            ReturnType = Optional.Instantiate([String]),
+        },
+        new Method
+        {
+            Name = "readFile",
+            ArgumentTypes = [String],
+            ReturnType = Optional.Instantiate([String]),
+        },
+        new Method
+        {
+            Name = "lines",
+            ArgumentTypes = [String],
+            ReturnType = LineIterator,
+        },
+        new Method
+        {
+            Name = "arguments",
+            ArgumentTypes = [],
+            ReturnType = Array.Instantiate([String]),
+        },
+        new Method
+        {
+            Name = "sleep",
+            ArgumentTypes = [Int],
+            ReturnType = Task.Instantiate([Void]),
+        },
+        new Method
+        {
+            Name = "readLineAsync",
+            ArgumentTypes = [],
+            ReturnType = Task.Instantiate([Optional.Instantiate([String])]),
+        },
+        .. new[] { Int, Double, Float }.SelectMany(ParallelMethods),
     ];
 
+    // Builtins that call a function on many elements at once, on several threads. The type checker
+    // only accepts functions that are safe to run that way.
+    private static IEnumerable<Method> ParallelMethods(Type elementType)
+    {
+        var arrayType = Array.Instantiate([elementType]);
+
+        yield return new Method
+        {
+            Name = "parallelMap",
+            ArgumentTypes = [arrayType, FunctionType(elementType, elementType)],
+            ReturnType = arrayType,
+        };
+        // The function must be associative, and `initial` an identity for it, but needn't be
+        // commutative: elements are combined in order.
+        yield return new Method
+        {
+            Name = "parallelReduce",
+            ArgumentTypes =
+            [
+                arrayType,
+                elementType,
+                FunctionType(elementType, elementType, elementType),
+            ],
+            ReturnType = elementType,
+        };
+    }
+
     public static readonly IReadOnlyCollection<Operator> Operators =
     [
         new Operator
@@ -557,6 +763,46 @@ public static class BuiltIns
             CppName = "->is_not_equal",
         },
         new Operator
+        {
+            Name = "<",
+            Fixity = OperatorFixity.Infix,
+            LhsType = String,
+            RhsType = String,
+            ReturnType = Bool,
+            IsCppOperator = true,
+            CppName = "->is_less",
+        },
+        new Operator
+        {
+            Name = "<=",
+            Fixity = OperatorFixity.Infix,
+            LhsType = String,
+            RhsType = String,
+            ReturnType = Bool,
+            IsCppOperator = true,
+            CppName = "->is_less_equal",
+        },
+        new Operator
+        {
+            Name = ">",
+            Fixity = OperatorFixity.Infix,
+            LhsType = String,
+            RhsType = String,
+            ReturnType = Bool,
+            IsCppOperator = true,
+            CppName = "->is_greater",
+        },
+        new Operator
+        {
+            Name = ">=",
+            Fixity = OperatorFixity.Infix,
+            LhsType = String,
+            RhsType = String,
+            ReturnType = Bool,
+            IsCppOperator = true,
+            CppName = "->is_greater_equal",
+        },
+        new Operator
         {
             Name = "??",
             Fixity = OperatorFixity.Infix,
@@ -568,12 +814,77 @@ public static class BuiltIns
             LambdaWrapRhs = true,
             GenericTypes = [OptionalGenericPlaceholder],
         },
+        .. SizedIntegerRanges.SelectMany(entry =>
+            SizedIntegerOperators(entry.Key, isSigned: entry.Value.Min < 0)
+        ),
     ];
 
+    // The same arithmetic and comparisons as Int. Only signed types can be negated.
+    private static IEnumerable<Operator> SizedIntegerOperators(Type type, bool isSigned)
+    {
+        foreach (var name in new[] { "+", "-", "*", "/", "%" })
+        {
+            yield return new Operator
+            {
+                Name = name,
+                Fixity = OperatorFixity.Infix,
+                LhsType = type,
+                RhsType = type,
+                ReturnType = type,
+                IsCppOperator = true,
+                CppName = name,
+            };
+        }
+
+        foreach (var name in new[] { "<", "<=", ">", ">=", "==", "!=" })
+        {
+            yield return new Operator
+            {
+                Name = name,
+                Fixity = OperatorFixity.Infix,
+                LhsType = type,
+                RhsType = type,
+                ReturnType = Bool,
+                IsCppOperator = true,
+                CppName = name,
+            };
+        }
+
+        if (isSigned)
+        {
+            yield return new Operator
+            {
+                Name = "-",
+                Fixity = OperatorFixity.Prefix,
+                RhsType = type,
+                ReturnType = type,
+                IsCppOperator = true,
+                CppName = "-",
+            };
+        }
+    }
+
+    // The type checker looks operators up by symbol far more often than it lists them all
+    public static readonly ILookup<(string, OperatorFixity), Operator> OperatorsBySymbol =
+        Operators.ToLookup(op => (op.Name, op.Fixity));
+
     static BuiltIns()
     {
         ObjectToStringMethod.ReturnType = String;
 
+        foreach (var method in StringSearchMethods)
+        {
+            String.Methods.Add(method);
+        }
+        String.Methods.Add(
+            new()
+            {
+                Name = "split",
+                ArgumentTypes = [String],
+                ReturnType = Array.Instantiate([String]),
+            }
+        );
+
         foreach (var method in Object.Methods)
         {
             method.ThisType = Object;
@@ -593,5 +904,10 @@ public static class BuiltIns
         {
             method.ThisType = Optional;
         }
+
+        foreach (var method in LineIterator.Methods)
+        {
+            method.ThisType = LineIterator;
+        }
     }
 }
@@ -28,3 +28,13 @@ public class TypeCheckException : Exception
         }
     }
 }
+
+// Either a value or the type error that prevented it. The type checker tries many overloads that
+// don't fit, so it reports those failures with this rather than by throwing.
+public readonly record struct CheckResult<T>(T? Value, TypeCheckException? Error)
+    where T : class
+{
+    public static implicit operator CheckResult<T>(T value) => new(value, null);
+
+    public static implicit operator CheckResult<T>(TypeCheckException error) => new(null, error);
+}
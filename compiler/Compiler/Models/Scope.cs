@@ -0,0 +1,56 @@
+namespace Compiler.Models;
+
+// A symbol table for one lexical scope, indexed by a key such as the symbol's name. Each scope only
+// stores the symbols declared in it and links to the scope it's nested in, so opening a new scope
+// copies nothing and lookups don't scan every visible symbol.
+public class Scope<TKey, TValue>
+    where TKey : notnull
+    where TValue : class
+{
+    private readonly Func<TValue, TKey> _keySelector;
+    private readonly Scope<TKey, TValue>? _parent;
+    private readonly Dictionary<TKey, List<TValue>> _symbols = [];
+
+    public Scope(Func<TValue, TKey> keySelector, IEnumerable<TValue>? values = null)
+    {
+        _keySelector = keySelector;
+        foreach (var value in values ?? [])
+        {
+            Add(value);
+        }
+    }
+
+    private Scope(Scope<TKey, TValue> parent)
+    {
+        _keySelector = parent._keySelector;
+        _parent = parent;
+    }
+
+    public Scope<TKey, TValue> Nested() => new(this);
+
+    public void Add(TValue value)
+    {
+        var key = _keySelector(value);
+        if (_symbols.TryGetValue(key, out var list))
+        {
+            list.Add(value);
+        }
+        else
+        {
+            _symbols.Add(key, [value]);
+        }
+    }
+
+    // Every visible symbol with this key, outermost scope first, in the order they were declared.
+    public IEnumerable<TValue> Lookup(TKey key)
+    {
+        var inherited = _parent?.Lookup(key) ?? [];
+        return _symbols.TryGetValue(key, out var list) ? inherited.Concat(list) : inherited;
+    }
+
+    // The most recently declared visible symbol with this key, which shadows any others.
+    public TValue? Find(TKey key) =>
+        _symbols.TryGetValue(key, out var list) ? list[^1] : _parent?.Find(key);
+
+    public bool DeclaresLocally(TKey key) => _symbols.ContainsKey(key);
+}
@@ -192,8 +192,9 @@ public class Type : IEquatable<Type>
             return true;
         }
 
-        var builtInNumerics = new List<Type> { BuiltIns.Int, BuiltIns.Float, BuiltIns.Double };
-        if (builtInNumerics.Contains(this) && builtInNumerics.Contains(other))
+        bool IsBuiltInNumeric(Type t) =>
+            BuiltIns.IntegerTypes.Contains(t) || t == BuiltIns.Float || t == BuiltIns.Double;
+        if (IsBuiltInNumeric(this) && IsBuiltInNumeric(other))
         {
             return true;
         }
@@ -280,6 +281,22 @@ public class Type : IEquatable<Type>
     public override bool Equals([NotNullWhen(true)] object? other) =>
         other is Type t && t.Equals(this);
 
+    // Int is int_fast32_t, which is the same C++ type as Int32 or Int64 depending on the platform,
+    // so generated C++ can't tell them apart, even as generic arguments.
+    public bool MayShareCppType(Type other) =>
+        this == other
+        || (this == BuiltIns.Int && (other == BuiltIns.Int32 || other == BuiltIns.Int64))
+        || (other == BuiltIns.Int && (this == BuiltIns.Int32 || this == BuiltIns.Int64))
+        || (
+            Name == other.Name
+            && IsObject == other.IsObject
+            && GenericTypes.Count > 0
+            && GenericTypes.Count == other.GenericTypes.Count
+            && Enumerable
+                .Zip(GenericTypes, other.GenericTypes)
+                .All(pair => pair.First.MayShareCppType(pair.Second))
+        );
+
     public override int GetHashCode() =>
         (Name, IsGenericPlaceholder, GenericTypes.Count, IsObject, BaseType).GetHashCode();
 
@@ -347,7 +364,7 @@ public class Method
                     var (thisType, otherType, i) = t;
                     return OriginallyGenericArguments[1 << i]
                         || other.OriginallyGenericArguments[1 << i]
-                        || thisType == otherType;
+                        || thisType.MayShareCppType(otherType);
                 }
             )
         && (
@@ -3,28 +3,38 @@ namespace Compiler.Models;
 public interface TypeCheckedStatement
 {
     public bool IsReturn => false;
+
+    // The source line the statement came from, which Codegen marks with a `#line` directive. Only
+    // set on statements, including expressions used as statements, and may be missing on those a
+    // pass made up.
+    public int? Line { get; set; }
+}
+
+public abstract class TypeCheckedNode
+{
+    public int? Line { get; set; }
 }
 
-public class TypeCheckedClass : TypeCheckedStatement
+public class TypeCheckedClass : TypeCheckedNode, TypeCheckedStatement
 {
     public Type Type { get; set; }
     public IEnumerable<TypeCheckedStatement> Body { get; set; }
 }
 
-public class TypeCheckedVar : TypeCheckedStatement
+public class TypeCheckedVar : TypeCheckedNode, TypeCheckedStatement
 {
     public string Name { get; set; }
     public Type Type { get; set; }
     public TypeCheckedExpression Value { get; set; }
 }
 
-public class TypeCheckedAssignment : TypeCheckedStatement
+public class TypeCheckedAssignment : TypeCheckedNode, TypeCheckedStatement
 {
     public TypeCheckedExpression Lhs { get; set; }
     public TypeCheckedExpression Rhs { get; set; }
 }
 
-public class TypeCheckedConditional : TypeCheckedStatement
+public class TypeCheckedConditional : TypeCheckedNode, TypeCheckedStatement
 {
     public TypeCheckedExpression Condition { get; set; }
     public IEnumerable<TypeCheckedStatement> TrueBlock { get; set; }
@@ -32,26 +42,51 @@ public class TypeCheckedConditional : TypeCheckedStatement
     public bool IsReturn => TrueBlock.Any(x => x.IsReturn) && FalseBlock.Any(x => x.IsReturn);
 }
 
-public class TypeCheckedLoop : TypeCheckedStatement
+public class TypeCheckedLoop : TypeCheckedNode, TypeCheckedStatement
 {
     public TypeCheckedExpression Condition { get; set; }
     public IEnumerable<TypeCheckedStatement> Body { get; set; }
 }
 
+// A `for` loop. What it iterates over is evaluated once, before the first iteration. The variable
+// is a fresh copy on each iteration, so assigning to it doesn't change which values come next.
+public abstract class TypeCheckedForLoop : TypeCheckedNode, TypeCheckedStatement
+{
+    public string Variable { get; set; }
+    public Type VariableType { get; set; }
+    public IEnumerable<TypeCheckedStatement> Body { get; set; }
+}
+
+// `for i in start..<end`, counting up from `start` to just below `end`.
+public class TypeCheckedRangeLoop : TypeCheckedForLoop
+{
+    public TypeCheckedExpression Start { get; set; }
+    public TypeCheckedExpression End { get; set; }
+}
+
+// `for x in array`. The loop iterates over the array as it was when the loop started; changes the
+// body makes to the array don't affect it.
+public class TypeCheckedArrayLoop : TypeCheckedForLoop
+{
+    public TypeCheckedExpression Array { get; set; }
+}
+
 public class TypeCheckedFunctionArgument
 {
     public string Name { get; set; }
     public Type Type { get; set; }
 }
 
-public class TypeCheckedFunctionDeclaration : TypeCheckedStatement
+public class TypeCheckedFunctionDeclaration : TypeCheckedNode, TypeCheckedStatement
 {
     public Method Method { get; set; }
     public IEnumerable<TypeCheckedStatement> Body { get; set; }
     public IEnumerable<TypeCheckedFunctionArgument> Arguments { get; set; }
+    // The method returns a Task, and the body returns what awaiting that Task produces.
+    public bool IsAsync { get; set; }
 }
 
-public class TypeCheckedReturnStatement : TypeCheckedStatement
+public class TypeCheckedReturnStatement : TypeCheckedNode, TypeCheckedStatement
 {
     public TypeCheckedExpression? Value { get; set; }
     bool TypeCheckedStatement.IsReturn => true;
@@ -62,31 +97,46 @@ public interface TypeCheckedExpression : TypeCheckedStatement
     Type Type { get; }
 }
 
-public class TypedIntegerLiteral : TypeCheckedExpression
+public class TypedIntegerLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public Type Type { get; set; }
     public long Value { get; set; }
 }
 
-public class TypedDecimalLiteral : TypeCheckedExpression
+public class TypedDecimalLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public Type Type { get; set; }
     public double Value { get; set; }
 }
 
-public class TypeCheckedStringLiteral : TypeCheckedExpression
+public class TypeCheckedStringLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public string Value { get; set; }
     Type TypeCheckedExpression.Type => BuiltIns.String;
 }
 
-public class TypeCheckedIdentifier : TypeCheckedExpression
+public class TypeCheckedIdentifier : TypeCheckedNode, TypeCheckedExpression
 {
     public Type Type { get; set; }
     public string Name { get; set; }
 }
 
-public class TypeCheckedFunctionCall : TypeCheckedExpression
+// A function named where a builtin expects a function, rather than called.
+public class TypeCheckedFunctionReference : TypeCheckedNode, TypeCheckedExpression
+{
+    public Method Method { get; set; }
+    public Type Type { get; set; }
+}
+
+// Waits for a Task and produces its result.
+public class TypeCheckedAwait : TypeCheckedNode, TypeCheckedExpression
+{
+    public TypeCheckedExpression Operand { get; set; }
+
+    Type TypeCheckedExpression.Type => Operand.Type.GenericTypes.Single();
+}
+
+public class TypeCheckedFunctionCall : TypeCheckedNode, TypeCheckedExpression
 {
     public Method Method { get; set; }
     public IEnumerable<TypeCheckedExpression> Arguments { get; set; }
@@ -94,13 +144,13 @@ public class TypeCheckedFunctionCall : TypeCheckedExpression
     Type TypeCheckedExpression.Type => Method.ReturnType;
 }
 
-public class TypeCheckedStringInterpolation : TypeCheckedExpression
+public class TypeCheckedStringInterpolation : TypeCheckedNode, TypeCheckedExpression
 {
     public IEnumerable<TypeCheckedExpression> Pieces { get; set; }
     Type TypeCheckedExpression.Type => BuiltIns.String;
 }
 
-public class TypeCheckedOperatorCall : TypeCheckedExpression
+public class TypeCheckedOperatorCall : TypeCheckedNode, TypeCheckedExpression
 {
     public Operator Operator { get; set; }
     public TypeCheckedExpression? Lhs { get; set; }
@@ -109,13 +159,13 @@ public class TypeCheckedOperatorCall : TypeCheckedExpression
     Type TypeCheckedExpression.Type => Operator.ReturnType;
 }
 
-public class TypeCheckedBooleanLiteral : TypeCheckedExpression
+public class TypeCheckedBooleanLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public bool Value { get; set; }
     Type TypeCheckedExpression.Type => BuiltIns.Bool;
 }
 
-public class TypeCheckedIndexAccess : TypeCheckedExpression
+public class TypeCheckedIndexAccess : TypeCheckedNode, TypeCheckedExpression
 {
     public TypeCheckedExpression Base { get; set; }
     public TypeCheckedExpression Index { get; set; }
@@ -126,24 +176,24 @@ public class TypeCheckedIndexAccess : TypeCheckedExpression
         Base.Type.Subscript?.ReturnType ?? throw new InvalidOperationException();
 }
 
-public class TypeCheckedCastExpression : TypeCheckedExpression
+public class TypeCheckedCastExpression : TypeCheckedNode, TypeCheckedExpression
 {
     public TypeCheckedExpression Base { get; set; }
     public Type Type { get; set; }
 }
 
-public class TypeCheckedArrayLiteral : TypeCheckedExpression
+public class TypeCheckedArrayLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public IEnumerable<TypeCheckedExpression> Values { get; set; }
     public Type Type { get; set; }
 }
 
-public class TypeCheckedNullLiteral : TypeCheckedExpression
+public class TypeCheckedNullLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public Type Type { get; set; }
 }
 
-public class TypeCheckedPropertyAccess : TypeCheckedExpression
+public class TypeCheckedPropertyAccess : TypeCheckedNode, TypeCheckedExpression
 {
     public TypeCheckedExpression Base { get; set; }
     public Property Property { get; set; }
@@ -151,7 +201,7 @@ public class TypeCheckedPropertyAccess : TypeCheckedExpression
     Type TypeCheckedExpression.Type => Property.Type;
 }
 
-public class TypeCheckedMethodCall : TypeCheckedExpression
+public class TypeCheckedMethodCall : TypeCheckedNode, TypeCheckedExpression
 {
     public TypeCheckedExpression Base { get; set; }
     public IEnumerable<TypeCheckedExpression> Arguments { get; set; }
@@ -160,7 +210,7 @@ public class TypeCheckedMethodCall : TypeCheckedExpression
     Type TypeCheckedExpression.Type => Method.ReturnType;
 }
 
-public class TypeCheckedCharLiteral : TypeCheckedExpression
+public class TypeCheckedCharLiteral : TypeCheckedNode, TypeCheckedExpression
 {
     public byte Value { get; set; }
 
@@ -5,42 +5,136 @@ using Compiler.Components;
 using Compiler.Models;
 using Compiler.Util;
 
-try
+var jsonOptions = new JsonSerializerOptions
 {
-    var jsonContent = File.ReadAllText(args[0]);
+    PropertyNamingPolicy = JsonNamingPolicy.CamelCase,
+    NumberHandling = JsonNumberHandling.AllowNamedFloatingPointLiterals,
+};
 
-    var decoded =
-        JsonSerializer.Deserialize<Dictionary<string, AstRoot>>(
-            jsonContent,
-            new JsonSerializerOptions
-            {
-                PropertyNamingPolicy = JsonNamingPolicy.CamelCase,
-                NumberHandling = JsonNumberHandling.AllowNamedFloatingPointLiterals,
-            }
-        ) ?? throw new Exception("Unexpected JSON null");
-
-    if (decoded.Count > 1)
+if (args is ["--server"])
+{
+    // Used by `falafel --daemon`, so that the runtime starts and warms up once for many programs.
+    // Each line of input is a request, answered by one line of output.
+    while (Console.In.ReadLine() is string line)
     {
-        throw new NotImplementedException("Compiling multiple files together is not supported.");
-    }
-
-    var root = decoded.Values.Single();
-
-    var typeCheckedStatements = new TypeChecker(root.LineCounts).CheckTypes(root.Ast);
+        var errors = new StringWriter();
+        int status;
+        try
+        {
+            var request =
+                JsonSerializer.Deserialize<ServerRequest>(line, jsonOptions)
+                ?? throw new Exception("Unexpected JSON null");
+            var files = new AstBinaryReader(Convert.FromBase64String(request.Ast)).Read();
+            status = Compile(files, request.Output, errors);
+        }
+        catch (Exception e)
+        {
+            errors.WriteLine("Malformed request: {0}", e.Message);
+            status = 1;
+        }
 
-    new Codegen().GenerateCode(typeCheckedStatements, args.Length > 1 ? args[1] : null);
+        Console.Out.WriteLine(
+            JsonSerializer.Serialize(new ServerResponse(status, errors.ToString()), jsonOptions)
+        );
+    }
     return 0;
 }
-catch (TypeCheckException tce)
+
+// `falafel --time-passes` passes this first, naming the file to write the time each phase took to.
+PassTimer? timer = null;
+string? timingsPath = null;
+if (args is ["--time-passes", var path, .. var rest])
 {
-    Console.Error.WriteLine("Type checking failed: {0}", tce.Message);
+    timer = new PassTimer();
+    timingsPath = path;
+    args = rest;
 }
-catch (AggregateException ae)
+
+Dictionary<string, AstRoot> decoded;
+try
 {
-    Console.Error.WriteLine(ae.Message);
+    byte[] content;
+    using (timer?.Phase("read"))
+    {
+        content = File.ReadAllBytes(args[0]);
+    }
+
+    // The CLI passes the binary AST, but the JSON from `falafel --emit-ast` is accepted too.
+    using (timer?.Phase("decode"))
+    {
+        decoded = AstBinaryReader.IsBinary(content)
+            ? new AstBinaryReader(content).Read()
+            : JsonSerializer.Deserialize<Dictionary<string, AstRoot>>(content, jsonOptions)
+                ?? throw new Exception("Unexpected JSON null");
+    }
 }
 catch (Exception e)
 {
     Console.Error.WriteLine("Unexpected exception. This likely represents a compiler bug.\n{0}", e);
+    return 1;
+}
+
+var exitCode = Compile(decoded, args.Length > 1 ? args[1] : null, Console.Error, timer);
+timer?.WriteTo(timingsPath!);
+return exitCode;
+
+static int Compile(
+    Dictionary<string, AstRoot> decoded,
+    string? location,
+    TextWriter errors,
+    PassTimer? timer = null
+)
+{
+    try
+    {
+        if (decoded.Count > 1)
+        {
+            // Each file gets its own translation unit, so the location is a directory.
+            if (location is null)
+            {
+                errors.WriteLine("An output directory is required when compiling several files.");
+                return 1;
+            }
+
+            new ModuleCompiler(decoded, timer, errors).Compile(location);
+            return 0;
+        }
+
+        var (sourceFile, root) = decoded.Single();
+
+        // Type checking is lazy, so the statements are collected here to time it on its own.
+        List<TypeCheckedStatement> typeCheckedStatements;
+        using (timer?.Phase("type check"))
+        {
+            typeCheckedStatements = new TypeChecker(root.LineCounts, errors)
+                .CheckTypes(root.Ast)
+                .ToList();
+        }
+
+        var optimizedStatements = new Optimizer(timer).Optimize(typeCheckedStatements);
+
+        using (timer?.Phase("codegen"))
+        {
+            new Codegen(sourceFile).GenerateCode(optimizedStatements, location);
+        }
+        return 0;
+    }
+    catch (TypeCheckException tce)
+    {
+        errors.WriteLine("Type checking failed: {0}", tce.Message);
+    }
+    catch (AggregateException ae)
+    {
+        errors.WriteLine(ae.Message);
+    }
+    catch (Exception e)
+    {
+        errors.WriteLine("Unexpected exception. This likely represents a compiler bug.\n{0}", e);
+    }
+    return 1;
 }
-return 1;
+
+// The AST is in the binary format, encoded in base64 to fit on one line.
+record ServerRequest(string Ast, string Output);
+
+record ServerResponse(int Status, string Errors);
@@ -0,0 +1,261 @@
+using System.Buffers.Binary;
+using System.Text;
+using Compiler.Models;
+
+namespace Compiler.Util;
+
+// Reads the binary AST written by parser/src/binary.js, which describes the format. Every node is
+// constructed directly, so unlike the JSON path this involves no reflection.
+public class AstBinaryReader(byte[] data)
+{
+    private static ReadOnlySpan<byte> Magic => [0x46, 0x4c, 0x41, 0x53, 0x54, 2];
+
+    private int _position = Magic.Length;
+    private string[] _strings = [];
+
+    public static bool IsBinary(ReadOnlySpan<byte> data) => data.StartsWith(Magic);
+
+    public Dictionary<string, AstRoot> Read()
+    {
+        if (!IsBinary(data))
+        {
+            throw new FormatException("Not a binary AST, or one from a different version");
+        }
+
+        _strings = new string[ReadCount()];
+        for (var i = 0; i < _strings.Length; ++i)
+        {
+            var length = ReadCount();
+            _strings[i] = Encoding.UTF8.GetString(Take(length));
+        }
+
+        var fileCount = ReadCount();
+        var result = new Dictionary<string, AstRoot>(fileCount);
+        for (var i = 0; i < fileCount; ++i)
+        {
+            var path = ReadString();
+
+            var lineCount = ReadCount();
+            var lineCounts = new List<ulong>(lineCount);
+            var offset = 0UL;
+            for (var j = 0; j < lineCount; ++j)
+            {
+                offset += ReadVarint();
+                lineCounts.Add(offset);
+            }
+
+            result.Add(path, new AstRoot { Ast = ReadList<AstNode>(), LineCounts = lineCounts });
+        }
+
+        if (_position != data.Length)
+        {
+            throw new FormatException("Unexpected data after the end of the AST");
+        }
+        return result;
+    }
+
+    private ReadOnlySpan<byte> Take(int count)
+    {
+        if (count > data.Length - _position)
+        {
+            throw new FormatException("Unexpected end of the AST");
+        }
+        var span = data.AsSpan(_position, count);
+        _position += count;
+        return span;
+    }
+
+    private byte ReadByte() => Take(1)[0];
+
+    private ulong ReadVarint()
+    {
+        var result = 0UL;
+        for (var shift = 0; shift < 64; shift += 7)
+        {
+            var b = ReadByte();
+            result |= (ulong)(b & 0x7f) << shift;
+            if (b < 0x80)
+            {
+                return result;
+            }
+        }
+        throw new FormatException("Varint is too long");
+    }
+
+    private int ReadCount() => checked((int)ReadVarint());
+
+    private string ReadString()
+    {
+        var index = ReadVarint();
+        if (index >= (ulong)_strings.Length)
+        {
+            throw new FormatException($"String index {index} is out of range");
+        }
+        return _strings[index];
+    }
+
+    private Location? ReadLocation()
+    {
+        var pos = ReadVarint();
+        if (pos == 0)
+        {
+            return null;
+        }
+        return new Location { Pos = pos - 1, Length = ReadVarint() };
+    }
+
+    private List<T> ReadList<T>()
+        where T : AstNode
+    {
+        var count = ReadCount();
+        var list = new List<T>(count);
+        for (var i = 0; i < count; ++i)
+        {
+            list.Add(Read<T>());
+        }
+        return list;
+    }
+
+    private AstType? ReadOptionalType()
+    {
+        if (ReadByte() == 0)
+        {
+            return null;
+        }
+
+        var loc = ReadLocation();
+        var name = ReadString();
+        var count = ReadCount();
+        var arguments = new List<AstType>(count);
+        for (var i = 0; i < count; ++i)
+        {
+            arguments.Add(ReadType());
+        }
+        return new AstType
+        {
+            Name = name,
+            Arguments = arguments,
+            Loc = loc,
+        };
+    }
+
+    private AstType ReadType() => ReadOptionalType() ?? throw new FormatException("Missing type");
+
+    private T Read<T>()
+        where T : AstNode
+    {
+        var node = ReadOptional();
+        if (node is T t)
+        {
+            return t;
+        }
+        throw new FormatException(
+            $"Expected {typeof(T).Name}, found {node?.GetType().Name ?? "nothing"}"
+        );
+    }
+
+    private AstNode? ReadOptional()
+    {
+        var tag = ReadByte();
+        if (tag == 0)
+        {
+            return null;
+        }
+
+        var loc = ReadLocation();
+        AstNode node = tag switch
+        {
+            1 => new ConditionalStatement
+            {
+                Condition = Read<Expression>(),
+                TrueBlock = ReadList<AstNode>(),
+                FalseBlock = ReadByte() == 0 ? null : ReadList<AstNode>(),
+            },
+            2 => new Assignment { Lhs = Read<AssignmentLhsAllowed>(), Rhs = Read<Expression>() },
+            3 => new LoopStatement { Condition = Read<Expression>(), Body = ReadList<AstNode>() },
+            4 => new ClassDefinition
+            {
+                Name = ReadString(),
+                Base = ReadOptionalType(),
+                Body = ReadList<Declaration>(),
+                Final = ReadByte() != 0,
+            },
+            5 => new VarDeclaration
+            {
+                Name = ReadString(),
+                DeclaredType = ReadType(),
+                Value = Read<Expression>(),
+            },
+            6 => new FunctionDeclaration
+            {
+                Name = ReadString(),
+                ReturnType = ReadOptionalType(),
+                Arguments = ReadArguments(),
+                Body = ReadList<AstNode>(),
+                Async = ReadByte() != 0,
+            },
+            7 => new ReturnStatement { Value = ReadOptional() as Expression },
+            8 => new FunctionCall { Function = ReadString(), Arguments = ReadList<Expression>() },
+            9 => new IntegerLiteral { Value = ReadZigzag() },
+            10 => new DecimalLiteral { Value = BinaryPrimitives.ReadDoubleLittleEndian(Take(8)) },
+            11 => new StringLiteral { Value = ReadString() },
+            12 => new StringInterpolation { Pieces = ReadList<Expression>() },
+            13 => new BinaryExpression
+            {
+                Lhs = Read<Expression>(),
+                Operator = ReadString(),
+                Rhs = Read<Expression>(),
+            },
+            14 => new Identifier { Name = ReadString() },
+            15 => new BooleanLiteral { Value = ReadByte() != 0 },
+            16 => new NullLiteral(),
+            17 => new PrefixExpression { Operator = ReadString(), Operand = Read<Expression>() },
+            18 => new CastExpression { Value = Read<Expression>(), DeclaredType = ReadType() },
+            19 => new IndexExpression { Base = Read<Expression>(), Index = Read<Expression>() },
+            20 => new ArrayLiteral { Values = ReadList<Expression>() },
+            21 => new MemberAccessExpression
+            {
+                Base = Read<Expression>(),
+                Member = Read<MemberAccessRhsAllowed>(),
+            },
+            22 => new CharLiteral { Value = (char)ReadByte() },
+            23 => new ConstructorCall { Target = ReadType(), Arguments = ReadList<Expression>() },
+            24 => new RangeLoopStatement
+            {
+                Variable = ReadString(),
+                Start = Read<Expression>(),
+                End = Read<Expression>(),
+                Body = ReadList<AstNode>(),
+            },
+            25 => new ArrayLoopStatement
+            {
+                Variable = ReadString(),
+                Array = Read<Expression>(),
+                Body = ReadList<AstNode>(),
+            },
+            26 => new AwaitExpression { Operand = Read<Expression>() },
+            _ => throw new FormatException($"Unknown node tag {tag}"),
+        };
+
+        node.Type = node.GetType().Name;
+        node.Loc = loc;
+        return node;
+    }
+
+    private List<FunctionArgument> ReadArguments()
+    {
+        var count = ReadCount();
+        var arguments = new List<FunctionArgument>(count);
+        for (var i = 0; i < count; ++i)
+        {
+            arguments.Add(new FunctionArgument { Name = ReadString(), Type = ReadType() });
+        }
+        return arguments;
+    }
+
+    private long ReadZigzag()
+    {
+        var zigzag = ReadVarint();
+        return (long)(zigzag >> 1) ^ -(long)(zigzag & 1);
+    }
+}
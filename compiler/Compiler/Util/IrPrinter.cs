@@ -0,0 +1,350 @@
+using System.Globalization;
+using System.Text;
+using Compiler.Models;
+
+namespace Compiler.Util;
+
+// Renders type-checked trees in a falafel-like syntax, for comparing the program before and after
+// optimization passes. Every operator call is parenthesized, so two expressions print the same
+// exactly when they have the same shape.
+public static class IrPrinter
+{
+    private const string Indent = "    ";
+
+    public static string Print(IEnumerable<TypeCheckedStatement> program)
+    {
+        var builder = new StringBuilder();
+        PrintBlock(builder, program, 0);
+        return builder.ToString();
+    }
+
+    public static string PrintExpression(TypeCheckedExpression expr)
+    {
+        var builder = new StringBuilder();
+        AppendExpression(builder, expr);
+        return builder.ToString();
+    }
+
+    public static string PrintType(Models.Type t) =>
+        t.GenericTypes.Count > 0
+            ? $"{t.Name}<{string.Join(", ", t.GenericTypes.Select(PrintType))}>"
+            : t.Name;
+
+    private static void PrintBlock(
+        StringBuilder builder,
+        IEnumerable<TypeCheckedStatement> block,
+        int depth
+    )
+    {
+        foreach (var statement in block)
+        {
+            PrintStatement(builder, statement, depth);
+        }
+    }
+
+    private static void PrintStatement(
+        StringBuilder builder,
+        TypeCheckedStatement statement,
+        int depth
+    )
+    {
+        AppendIndent(builder, depth);
+
+        if (statement is TypeCheckedVar v)
+        {
+            builder.Append($"var {v.Name}: {PrintType(v.Type)} = ");
+            AppendExpression(builder, v.Value);
+            builder.Append('\n');
+        }
+        else if (statement is TypeCheckedAssignment a)
+        {
+            AppendExpression(builder, a.Lhs);
+            builder.Append(" = ");
+            AppendExpression(builder, a.Rhs);
+            builder.Append('\n');
+        }
+        else if (statement is TypeCheckedConditional c)
+        {
+            builder.Append("if ");
+            AppendExpression(builder, c.Condition);
+            builder.Append(" {\n");
+            PrintBlock(builder, c.TrueBlock, depth + 1);
+            if (c.FalseBlock.Any())
+            {
+                AppendIndent(builder, depth);
+                builder.Append("} else {\n");
+                PrintBlock(builder, c.FalseBlock, depth + 1);
+            }
+            AppendIndent(builder, depth);
+            builder.Append("}\n");
+        }
+        else if (statement is TypeCheckedLoop l)
+        {
+            builder.Append("while ");
+            AppendExpression(builder, l.Condition);
+            builder.Append(" {\n");
+            PrintBlock(builder, l.Body, depth + 1);
+            AppendIndent(builder, depth);
+            builder.Append("}\n");
+        }
+        else if (statement is TypeCheckedForLoop f)
+        {
+            builder.Append($"for {f.Variable} in ");
+            if (f is TypeCheckedRangeLoop r)
+            {
+                AppendExpression(builder, r.Start);
+                builder.Append("..<");
+                AppendExpression(builder, r.End);
+            }
+            else
+            {
+                AppendExpression(builder, ((TypeCheckedArrayLoop)f).Array);
+            }
+            builder.Append(" {\n");
+            PrintBlock(builder, f.Body, depth + 1);
+            AppendIndent(builder, depth);
+            builder.Append("}\n");
+        }
+        else if (statement is TypeCheckedFunctionDeclaration fd)
+        {
+            var arguments = string.Join(
+                ", ",
+                fd.Arguments.Select(a => $"{a.Name}: {PrintType(a.Type)}")
+            );
+            if (fd.IsAsync)
+            {
+                var awaitedType = PrintType(fd.Method.ReturnType.GenericTypes.Single());
+                builder.Append($"async func {fd.Method.Name}({arguments}): {awaitedType} {{\n");
+            }
+            else
+            {
+                var returnType = PrintType(fd.Method.ReturnType);
+                builder.Append($"func {fd.Method.Name}({arguments}): {returnType} {{\n");
+            }
+            PrintBlock(builder, fd.Body, depth + 1);
+            AppendIndent(builder, depth);
+            builder.Append("}\n");
+        }
+        else if (statement is TypeCheckedReturnStatement rs)
+        {
+            builder.Append("return");
+            if (rs.Value is not null)
+            {
+                builder.Append(' ');
+                AppendExpression(builder, rs.Value);
+            }
+            builder.Append('\n');
+        }
+        else if (statement is TypeCheckedExpression expr)
+        {
+            AppendExpression(builder, expr);
+            builder.Append('\n');
+        }
+        else
+        {
+            builder.Append($"<{statement.GetType().Name}>\n");
+        }
+    }
+
+    private static void AppendIndent(StringBuilder builder, int depth)
+    {
+        for (var i = 0; i < depth; ++i)
+        {
+            builder.Append(Indent);
+        }
+    }
+
+    private static void AppendExpression(StringBuilder builder, TypeCheckedExpression expr)
+    {
+        if (expr is TypedIntegerLiteral il)
+        {
+            builder.Append(il.Value.ToString(CultureInfo.InvariantCulture));
+            if (il.Type != BuiltIns.Int)
+            {
+                builder.Append($" as {PrintType(il.Type)}");
+            }
+        }
+        else if (expr is TypedDecimalLiteral dl)
+        {
+            builder.Append(dl.Value.ToString("R", CultureInfo.InvariantCulture));
+            if (dl.Type == BuiltIns.Float)
+            {
+                builder.Append('f');
+            }
+        }
+        else if (expr is TypeCheckedStringLiteral sl)
+        {
+            builder.Append('"');
+            AppendEscaped(builder, sl.Value, '"');
+            builder.Append('"');
+        }
+        else if (expr is TypeCheckedCharLiteral cl)
+        {
+            builder.Append(
+                cl.Value is >= 0x20 and < 0x7f and not (byte)'\'' and not (byte)'\\'
+                    ? $"'{(char)cl.Value}'"
+                    : $"'\\x{cl.Value:x2}'"
+            );
+        }
+        else if (expr is TypeCheckedBooleanLiteral bl)
+        {
+            builder.Append(bl.Value ? "true" : "false");
+        }
+        else if (expr is TypeCheckedNullLiteral nl)
+        {
+            builder.Append($"null as {PrintType(nl.Type)}");
+        }
+        else if (expr is TypeCheckedIdentifier i)
+        {
+            builder.Append(i.Name);
+        }
+        else if (expr is TypeCheckedAwait aw)
+        {
+            builder.Append("(await ");
+            AppendExpression(builder, aw.Operand);
+            builder.Append(')');
+        }
+        else if (expr is TypeCheckedFunctionReference fr)
+        {
+            builder.Append($"{fr.Method.Name} as {PrintType(fr.Type)}");
+        }
+        else if (expr is TypeCheckedStringInterpolation si)
+        {
+            builder.Append('`');
+            foreach (var piece in si.Pieces)
+            {
+                if (piece is TypeCheckedStringLiteral literal)
+                {
+                    AppendEscaped(builder, literal.Value, '`');
+                }
+                else
+                {
+                    builder.Append("${");
+                    AppendExpression(builder, piece);
+                    builder.Append('}');
+                }
+            }
+            builder.Append('`');
+        }
+        else if (expr is TypeCheckedOperatorCall o)
+        {
+            builder.Append('(');
+            if (o.Lhs is not null)
+            {
+                AppendExpression(builder, o.Lhs);
+                builder.Append(o.Rhs is null ? " " : $" {o.Operator.Name} ");
+            }
+            else
+            {
+                builder.Append(o.Operator.Name);
+            }
+            if (o.Rhs is not null)
+            {
+                AppendExpression(builder, o.Rhs);
+            }
+            else
+            {
+                builder.Append(o.Operator.Name);
+            }
+            builder.Append(')');
+        }
+        else if (expr is TypeCheckedFunctionCall fc)
+        {
+            builder.Append(fc.Method is Constructor c ? PrintType(c.ThisType) : fc.Method.Name);
+            AppendArguments(builder, fc.Arguments);
+        }
+        else if (expr is TypeCheckedMethodCall mc)
+        {
+            AppendExpression(builder, mc.Base);
+            builder.Append($".{mc.Method.Name}");
+            AppendArguments(builder, mc.Arguments);
+        }
+        else if (expr is TypeCheckedPropertyAccess pa)
+        {
+            AppendExpression(builder, pa.Base);
+            builder.Append($".{pa.Property.Name}");
+        }
+        else if (expr is TypeCheckedIndexAccess ia)
+        {
+            AppendExpression(builder, ia.Base);
+            builder.Append('[');
+            AppendExpression(builder, ia.Index);
+            builder.Append(']');
+        }
+        else if (expr is TypeCheckedCastExpression cast)
+        {
+            builder.Append('(');
+            AppendExpression(builder, cast.Base);
+            builder.Append($" @ {PrintType(cast.Type)})");
+        }
+        else if (expr is TypeCheckedArrayLiteral al)
+        {
+            builder.Append('[');
+            var first = true;
+            foreach (var value in al.Values)
+            {
+                if (!first)
+                {
+                    builder.Append(", ");
+                }
+                first = false;
+                AppendExpression(builder, value);
+            }
+            builder.Append($"] as {PrintType(al.Type)}");
+        }
+        else
+        {
+            builder.Append($"<{expr.GetType().Name}>");
+        }
+    }
+
+    private static void AppendArguments(
+        StringBuilder builder,
+        IEnumerable<TypeCheckedExpression> arguments
+    )
+    {
+        builder.Append('(');
+        var first = true;
+        foreach (var argument in arguments)
+        {
+            if (!first)
+            {
+                builder.Append(", ");
+            }
+            first = false;
+            AppendExpression(builder, argument);
+        }
+        builder.Append(')');
+    }
+
+    private static void AppendEscaped(StringBuilder builder, string s, char quote)
+    {
+        foreach (var c in s)
+        {
+            if (c == quote || c == '\\' || (quote == '`' && c == '$'))
+            {
+                builder.Append('\\').Append(c);
+            }
+            else if (c == '\n')
+            {
+                builder.Append(@"\n");
+            }
+            else if (c == '\r')
+            {
+                builder.Append(@"\r");
+            }
+            else if (c == '\t')
+            {
+                builder.Append(@"\t");
+            }
+            else if (c < ' ' || c == '\x7f')
+            {
+                builder.Append($"\\u{(int)c:x4}");
+            }
+            else
+            {
+                builder.Append(c);
+            }
+        }
+    }
+}
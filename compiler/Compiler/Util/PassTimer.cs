@@ -0,0 +1,90 @@
+using System.Diagnostics;
+using System.Text.Json;
+
+namespace Compiler.Util;
+
+// Times the phases of compilation for `falafel --time-passes`. They are written to a file as Chrome
+// trace events, which the CLI merges with the steps it times itself. Phases that run in parallel go
+// in lanes of their own and leave out CPU time, since only the whole process's is available.
+public class PassTimer
+{
+    private readonly List<TraceEvent> events = [];
+
+    public PassTimer()
+    {
+        // Everything before this is the runtime starting up and JIT-compiling the start of Main.
+        using var process = Process.GetCurrentProcess();
+        var start = (process.StartTime.ToUniversalTime() - DateTime.UnixEpoch).TotalMicroseconds;
+        Record(".NET startup", start, 0, process.TotalProcessorTime);
+    }
+
+    // Times everything until the result is disposed, as in `using (timer?.Phase("codegen")) ...`.
+    public IDisposable Phase(string name, int lane = 0) => new RunningPhase(this, name, lane);
+
+    public void WriteTo(string path)
+    {
+        lock (events)
+        {
+            File.WriteAllText(
+                path,
+                JsonSerializer.Serialize(
+                    events,
+                    new JsonSerializerOptions { PropertyNamingPolicy = JsonNamingPolicy.CamelCase }
+                )
+            );
+        }
+    }
+
+    // Microseconds since the Unix epoch, the clock the CLI uses too.
+    private static double Now() => (DateTime.UtcNow - DateTime.UnixEpoch).TotalMicroseconds;
+
+    private static TimeSpan ProcessorTime()
+    {
+        using var process = Process.GetCurrentProcess();
+        return process.TotalProcessorTime;
+    }
+
+    private void Record(string name, double start, int lane, TimeSpan? cpu)
+    {
+        var args = new Dictionary<string, double>();
+        if (cpu is TimeSpan time)
+        {
+            args["cpuMs"] = time.TotalMilliseconds;
+        }
+
+        lock (events)
+        {
+            events.Add(new(name, "X", start, Now() - start, Environment.ProcessId, lane, args));
+        }
+    }
+
+    private sealed class RunningPhase : IDisposable
+    {
+        private readonly PassTimer timer;
+        private readonly string name;
+        private readonly int lane;
+        private readonly double start = Now();
+        private readonly TimeSpan? cpuStart;
+
+        public RunningPhase(PassTimer timer, string name, int lane)
+        {
+            this.timer = timer;
+            this.name = name;
+            this.lane = lane;
+            cpuStart = lane == 0 ? ProcessorTime() : null;
+        }
+
+        public void Dispose() =>
+            timer.Record(name, start, lane, cpuStart is null ? null : ProcessorTime() - cpuStart);
+    }
+
+    private record TraceEvent(
+        string Name,
+        string Ph,
+        double Ts,
+        double Dur,
+        int Pid,
+        int Tid,
+        Dictionary<string, double> Args
+    );
+}
@@ -0,0 +1,62 @@
+// Compares handing the compiler the AST as JSON against the binary encoding, on a large generated
+// source file. Run with `make bench-ast`, which builds the parser and compiler first.
+
+import * as fs from 'node:fs';
+import { devNull, tmpdir } from 'node:os';
+import * as path from 'node:path';
+import { time } from '../../bench/time.js';
+
+const FUNCTION_COUNT = 5000;
+const RUNS = 5;
+
+const bin = path.join(import.meta.dirname, '..', '..', 'dist', 'bin');
+const dir = fs.mkdtempSync(path.join(tmpdir(), 'falafel-bench-'));
+
+const generate = () => {
+  const lines = [];
+  for (let i = 0; i < FUNCTION_COUNT; ++i) {
+    lines.push(
+      `func step${i}(n: Int, label: String): Int {`,
+      `    var total: Int = n * ${i} + 0x${i.toString(16)}`,
+      `    var scale: Double = ${i}.5e-3`,
+      `    var values: Array<Int> = [1, 2, ${i}]`,
+      `    while (total > ${i + 100}) {`,
+      `        total = total / 2 - ${i % 7}`,
+      `    }`,
+      `    if (label.length() > ${i % 13} && total != -${i + 1}) {`,
+      `        print(\`\${label} ${i}: \${total} \${scale} \${values}\`)`,
+      `    }`,
+      `    return total`,
+      `}`,
+      `print(\`\${step${i}(${i}, "step ${i}")}\`)`
+    );
+  }
+  return `${lines.join('\n')}\n`;
+};
+
+try {
+  const source = path.join(dir, 'bench.fl');
+  fs.writeFileSync(source, generate());
+  const size = fs.statSync(source).size;
+  console.log(`${FUNCTION_COUNT} functions, ${size} bytes, best of ${RUNS}`);
+
+  const parser = path.join(bin, 'parser');
+  const compiler = path.join(bin, 'compiler');
+
+  for (const [name, flags, file] of [
+    ['JSON', [], 'ast.json'],
+    ['binary', ['--binary'], 'ast.bin'],
+  ]) {
+    const ast = path.join(dir, file);
+    const parse = time(RUNS, parser, [...flags, source], ast);
+    const compile = time(RUNS, compiler, [ast, devNull]);
+    const bytes = String(fs.statSync(ast).size).padStart(10);
+    console.log(
+      `${name.padEnd(6)} ${bytes} bytes` +
+        `  parser ${parse.toFixed(0).padStart(6)} ms` +
+        `  compiler ${compile.toFixed(0).padStart(6)} ms`
+    );
+  }
+} finally {
+  fs.rmSync(dir, { recursive: true });
+}
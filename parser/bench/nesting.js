@@ -0,0 +1,56 @@
+// Checks that the compiler's time grows linearly with how deeply overloaded operators nest, by
+// compiling chains of additions of increasing length. Every `+` has overloads for each numeric
+// type, and each of them checks the whole chain to its left, so without the type checker
+// remembering what it has checked this takes exponential time. The deepest chain stays well short
+// of where the type checker's recursion runs out of stack. Run with `make bench-nesting`, which
+// builds the parser and compiler first.
+
+import * as fs from 'node:fs';
+import { devNull, tmpdir } from 'node:os';
+import * as path from 'node:path';
+import { time } from '../../bench/time.js';
+
+const DEPTHS = [64, 128, 256, 512, 1024];
+// Chains per program, so that the time isn't all startup.
+const CHAINS = 100;
+const RUNS = 3;
+
+const bin = path.join(import.meta.dirname, '..', '..', 'dist', 'bin');
+const dir = fs.mkdtempSync(path.join(tmpdir(), 'falafel-bench-'));
+
+// Integer literals fit more overloads than the Double they end up as, which is what makes
+// resolving the chain expensive.
+const generate = (depth) => {
+  const terms = ['x'];
+  for (let i = 1; i < depth; ++i) {
+    terms.push(i % 2 === 0 ? 'x' : `${i}`);
+  }
+  const lines = ['var x: Double = 1.5'];
+  for (let i = 0; i < CHAINS; ++i) {
+    lines.push(`var total${i}: Double = ${terms.join(' + ')}`);
+  }
+  lines.push('print(`${total0}`)');
+  return `${lines.join('\n')}\n`;
+};
+
+try {
+  const parser = path.join(bin, 'parser');
+  const compiler = path.join(bin, 'compiler');
+  const source = path.join(dir, 'bench.fl');
+  const ast = path.join(dir, 'ast.bin');
+
+  console.log(`best of ${RUNS}`);
+  for (const depth of DEPTHS) {
+    fs.writeFileSync(source, generate(depth));
+    time(1, parser, ['--binary', source], ast);
+    const compile = time(RUNS, compiler, [ast, devNull]);
+    const perOperator = (compile * 1000) / (CHAINS * (depth - 1));
+    console.log(
+      `${String(depth - 1).padStart(6)} deep` +
+        `  compiler ${compile.toFixed(0).padStart(6)} ms` +
+        `  ${perOperator.toFixed(1).padStart(6)} µs each`
+    );
+  }
+} finally {
+  fs.rmSync(dir, { recursive: true });
+}
@@ -0,0 +1,64 @@
+// Checks that the compiler's time grows linearly with the number of declarations, by compiling
+// generated programs of increasing size. Each one declares a function and a global variable per
+// step, and every function calls the one before it and opens a few nested scopes. Run with
+// `make bench-scopes`, which builds the parser and compiler first.
+
+import * as fs from 'node:fs';
+import { devNull, tmpdir } from 'node:os';
+import * as path from 'node:path';
+import { time } from '../../bench/time.js';
+
+const STEP_COUNTS = [2500, 5000, 10000, 20000, 40000];
+const RUNS = 3;
+
+const bin = path.join(import.meta.dirname, '..', '..', 'dist', 'bin');
+const dir = fs.mkdtempSync(path.join(tmpdir(), 'falafel-bench-'));
+
+const generate = (count) => {
+  const lines = [];
+  for (let i = 0; i < count; ++i) {
+    const previous = i === 0 ? 'n' : `f${i - 1}(n - 1)`;
+    lines.push(
+      `func f${i}(n: Int): Int {`,
+      `    var a: Int = n + ${i}`,
+      `    if (a > ${i % 17}) {`,
+      `        var b: Int = a * 2`,
+      `        while (b > ${i + 100}) {`,
+      `            var c: Int = b / 2`,
+      `            b = c - 1`,
+      `        }`,
+      `        a = b`,
+      `    }`,
+      `    if (n > 0) {`,
+      `        return ${previous} + a`,
+      `    }`,
+      `    return a`,
+      `}`,
+      `var v${i}: Int = f${i}(${i % 3})`
+    );
+  }
+  lines.push(`print(\`\${v${count - 1}}\`)`);
+  return `${lines.join('\n')}\n`;
+};
+
+try {
+  const parser = path.join(bin, 'parser');
+  const compiler = path.join(bin, 'compiler');
+  const source = path.join(dir, 'bench.fl');
+  const ast = path.join(dir, 'ast.bin');
+
+  console.log(`best of ${RUNS}`);
+  for (const count of STEP_COUNTS) {
+    fs.writeFileSync(source, generate(count));
+    time(1, parser, ['--binary', source], ast);
+    const compile = time(RUNS, compiler, [ast, devNull]);
+    const perDeclaration = (compile * 1000) / (2 * count);
+    console.log(
+      `${String(2 * count).padStart(6)} declarations` +
+        `  compiler ${compile.toFixed(0).padStart(6)} ms` +
+        `  ${perDeclaration.toFixed(1).padStart(6)} µs each`
+    );
+  }
+} finally {
+  fs.rmSync(dir, { recursive: true });
+}
@@ -1,22 +1,88 @@
 import { parse } from './parser.hera';
+import { encodeFiles } from './binary.js';
+import { writeFileSync } from 'node:fs';
 import { readFile } from 'node:fs/promises';
+import { createInterface } from 'node:readline';
 import JSONBig from 'true-json-bigint';
 
-const paths = process.argv.slice(2);
-const result = {};
+const parseFiles = (paths) =>
+  // The files stay in the order they were given in, since the compiler treats the first one as the
+  // main module.
+  Promise.all(
+    paths.map(async (path) => {
+      const data = await readFile(path, { encoding: 'utf-8' });
+      const ast = parse(data, { filename: path });
 
-await Promise.all(
-  paths.map(async (path) => {
-    const data = await readFile(path, { encoding: 'utf-8' });
-    const ast = parse(data, { filename: path });
+      const lineCounts = [];
+      for (const match of data.matchAll(/\n/gu)) {
+        lineCounts.push(match.index);
+      }
 
-    const lineCounts = [];
-    for (const match of data.matchAll(/\n/gu)) {
-      lineCounts.push(match.index);
-    }
+      return [path, { ast, lineCounts }];
+    })
+  );
+
+// `falafel --time-passes` passes this first, naming the file to write the time each phase took to,
+// as Chrome trace events with timestamps in microseconds since the Unix epoch.
+let args = process.argv.slice(2);
+let timingsPath;
+if (args[0] === '--time-passes') {
+  timingsPath = args[1];
+  args = args.slice(2);
+}
+
+const events = [];
+const now = () => (performance.timeOrigin + performance.now()) * 1000;
+const record = (name, start, cpuStart) => {
+  const { user, system } = process.cpuUsage(cpuStart);
+  events.push({
+    name,
+    ph: 'X',
+    ts: start,
+    dur: now() - start,
+    pid: process.pid,
+    tid: 0,
+    args: { cpuMs: (user + system) / 1000 },
+  });
+};
+const timed = async (name, action) => {
+  const start = now();
+  const cpuStart = process.cpuUsage();
+  try {
+    return await action();
+  } finally {
+    record(name, start, cpuStart);
+  }
+};
 
-    result[path] = { ast, lineCounts };
-  })
-);
+// Everything before this is Node starting up and loading the parser.
+record('Node startup', performance.timeOrigin * 1000);
+
+if (args[0] === '--server') {
+  // Used by `falafel --daemon`. Each line of input is a JSON array of paths. It is answered by a
+  // line with the binary AST for those paths in base64, or with a JSON string holding the error
+  // message if parsing fails.
+  for await (const line of createInterface({ input: process.stdin })) {
+    let response;
+    try {
+      const files = await parseFiles(JSON.parse(line));
+      response = encodeFiles(files).toString('base64');
+    } catch (e) {
+      response = JSON.stringify(e instanceof Error ? e.message : String(e));
+    }
+    process.stdout.write(`${response}\n`);
+  }
+} else if (args[0] === '--binary') {
+  // The compact encoding from binary.js, which is what the compiler is normally given.
+  const files = await timed('parse', () => parseFiles(args.slice(1)));
+  const encoded = await timed('encode', () => encodeFiles(files));
+  await timed('write', () => process.stdout.write(encoded));
+} else {
+  const files = await timed('parse', () => parseFiles(args));
+  const json = await timed('serialize JSON', () => JSONBig.stringify(Object.fromEntries(files)));
+  await timed('write', () => console.log(json));
+}
 
-console.log(JSONBig.stringify(result));
+if (timingsPath !== undefined) {
+  writeFileSync(timingsPath, JSON.stringify(events));
+}
@@ -0,0 +1,33 @@
+import * as assert from 'node:assert/strict';
+import { test } from 'node:test';
+import { encodeFiles } from '../src/binary.js';
+
+const encodeLiteral = (value) =>
+  encodeFiles([['main.fl', { ast: [{ type: 'IntegerLiteral', value }], lineCounts: [] }]]);
+
+// Reads back the literal, which is the last thing in the file, the way AstBinaryReader does. The
+// byte before it is the literal's empty location, so the varint starts after the last byte before
+// the end without its high bit set.
+const decodeLiteral = (bytes) => {
+  let start = bytes.length - 1;
+  while (bytes[start - 1] >= 0x80) {
+    --start;
+  }
+  let zigzag = 0n;
+  for (let i = bytes.length - 1; i >= start; --i) {
+    zigzag = (zigzag << 7n) | BigInt(bytes[i] & 0x7f);
+  }
+  return BigInt.asIntN(64, (zigzag >> 1n) ^ -(zigzag & 1n));
+};
+
+test('integer literals at the ends of the 64-bit range round-trip', () => {
+  for (const value of [0n, -1n, 1n, -(1n << 63n), (1n << 63n) - 1n, -(1n << 31n), 1n << 31n]) {
+    assert.equal(decodeLiteral(encodeLiteral(value)), value);
+  }
+});
+
+test('integer literals outside the 64-bit range are rejected', () => {
+  for (const value of [1n << 63n, -(1n << 63n) - 1n, 1n << 64n]) {
+    assert.throws(() => encodeLiteral(value), RangeError);
+  }
+});
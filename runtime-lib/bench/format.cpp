@@ -0,0 +1,89 @@
+// Compares StringBuilder's number formatting against the snprintf calls it used to make.
+
+#include "../src/stringbuilder.hh"
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+constexpr size_t VALUE_COUNT = 1U << 20U;
+constexpr size_t VALUES_PER_STRING = 1024U;
+
+// Keeps the optimizer from discarding the formatted output.
+static volatile size_t sink;
+
+static uint64_t next_random(uint64_t& state) noexcept
+{
+    // xorshift64
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    return state;
+}
+
+template<typename F>
+static double nanoseconds_per_value(F func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / VALUE_COUNT;
+}
+
+template<typename T>
+static double time_snprintf(const std::vector<T>& values, const char* format)
+{
+    return nanoseconds_per_value([&] {
+        char buffer[32U];
+        size_t total = 0U;
+        for (T value : values) {
+            total += static_cast<size_t>(snprintf(buffer, sizeof buffer, format, value));
+        }
+        sink = total;
+    });
+}
+
+template<typename T>
+static double time_string_builder(const std::vector<T>& values)
+{
+    return nanoseconds_per_value([&] {
+        size_t total = 0U;
+        for (size_t i = 0U; i < values.size(); i += VALUES_PER_STRING) {
+            StringBuilder sb(VALUES_PER_STRING * 8U);
+            for (size_t j = i; j < i + VALUES_PER_STRING; ++j) {
+                sb.add_piece(values[j]);
+            }
+            total += sb.build()->length();
+        }
+        sink = total;
+    });
+}
+
+static void report(const char* name, double before, double after)
+{
+    printf("%-8s %10.1f %15.1f %9.2fx\n", name, before, after, before / after);
+}
+
+int main()
+{
+    uint64_t state = 0x9E37'79B9'7F4A'7C15ULL;
+
+    std::vector<Int> ints(VALUE_COUNT);
+    std::vector<Double> doubles(VALUE_COUNT);
+    std::vector<Float> floats(VALUE_COUNT);
+    for (size_t i = 0U; i < VALUE_COUNT; ++i) {
+        uint64_t bits = next_random(state);
+        // Mix small and large magnitudes, as in real output.
+        ints[i] = static_cast<Int>(bits >> (bits % 64U));
+        doubles[i] = static_cast<Double>(bits % 1'000'000U) / 1000.0;
+        floats[i] = static_cast<Float>(bits % 100'000U) / 100.0f;
+    }
+
+    printf("%-8s %10s %15s %10s\n", "type", "snprintf", "StringBuilder", "speedup");
+    printf("%-8s %10s %15s\n", "", "(ns/value)", "(ns/value)");
+    report("Int", time_snprintf(ints, "%" PRIdFAST32), time_string_builder(ints));
+    report("Double", time_snprintf(doubles, "%.17g"), time_string_builder(doubles));
+    // snprintf promotes Float to double either way.
+    report("Float", time_snprintf(floats, "%.9g"), time_string_builder(floats));
+}
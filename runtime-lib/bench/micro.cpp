@@ -0,0 +1,193 @@
+// Microbenchmarks of the runtime's hot paths. Each result is the best of several runs, one per
+// line as `name nanoseconds ns/op`, which `make bench` parses and compares against a baseline.
+
+#include "../src/array.hh"
+#include "../src/cow.hh"
+#include "../src/refcount.hh"
+#include "../src/string.hh"
+#include "../src/stringbuilder.hh"
+#include "../src/typeinfo.hh"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+constexpr int RUNS = 5;
+
+// Keeps the optimizer from discarding the results.
+static volatile size_t sink;
+
+// A class with a single reference, for building cycles.
+class Node final : public Object {
+public:
+    RcPointer<Node> next;
+
+    ~Node() noexcept override
+    {
+        // The collector already released `next` if it found this node in a garbage cycle.
+        if (children_released()) {
+            next.null_without_release();
+        }
+    }
+
+protected:
+    void visit_children(std::function<void(Object*)> visitor) override { visitor(next); }
+};
+
+// `func` does `operations` of whatever is being measured.
+template<typename F>
+static void run(const char* name, size_t operations, F func)
+{
+    double best = 0.0;
+    for (int i = 0; i < RUNS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        auto end = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    printf("%-24s %10.2f ns/op\n", name, best / static_cast<double>(operations));
+    fflush(stdout);
+}
+
+static void bench_refcounting()
+{
+    constexpr size_t COUNT = 1U << 24U;
+
+    // A leaf is never a candidate cycle root, so releasing it only decrements.
+    RcPointer<Object> leaf = new Object(LeafMarker {});
+    run("retain_release_leaf", COUNT, [&] {
+        for (size_t i = 0U; i < COUNT; ++i) {
+            RcPointer<Object> copy = leaf;
+            sink = copy->is_unique();
+        }
+    });
+
+    // Releasing anything else to a nonzero count also marks it as a possible cycle root.
+    RcPointer<Node> node = new Node();
+    run("retain_release", COUNT, [&] {
+        for (size_t i = 0U; i < COUNT; ++i) {
+            RcPointer<Node> copy = node;
+            sink = copy->is_unique();
+        }
+    });
+    Object::collect_cycles();
+}
+
+static void bench_collect_cycles()
+{
+    // Few enough rings that their roots fit in the buffer, so collection happens when asked.
+    constexpr size_t RING_COUNT = MAX_NUM_ROOTS / 2U;
+    constexpr size_t RING_LENGTH = 64U;
+
+    run("collect_cycles", RING_COUNT * RING_LENGTH, [] {
+        for (size_t i = 0U; i < RING_COUNT; ++i) {
+            RcPointer<Node> first = new Node();
+            Node* last = first;
+            for (size_t j = 1U; j < RING_LENGTH; ++j) {
+                last->next = new Node();
+                last = last->next;
+            }
+            last->next = first;
+        }
+        Object::collect_cycles();
+    });
+}
+
+static void bench_cow_buffer()
+{
+    constexpr size_t PUSH_COUNT = 1U << 22U;
+    run("cowbuffer_push", PUSH_COUNT, [] {
+        Array<Int> array;
+        for (size_t i = 0U; i < PUSH_COUNT; ++i) {
+            array.push(static_cast<Int>(i));
+        }
+        sink = array.length();
+    });
+
+    constexpr size_t COPY_COUNT = 1U << 14U;
+    constexpr size_t LENGTH = 1024U;
+    CowBuffer<Int> original(LENGTH);
+    original.length_mut() = LENGTH;
+    for (size_t i = 0U; i < LENGTH; ++i) {
+        original[i] = static_cast<Int>(i);
+    }
+    run("cowbuffer_ensure_unique", COPY_COUNT, [&] {
+        for (size_t i = 0U; i < COPY_COUNT; ++i) {
+            CowBuffer<Int> copy = original;
+            copy.ensure_unique();
+            copy[0U] = 1;
+            sink = copy.length();
+        }
+    });
+}
+
+static void bench_strings()
+{
+    constexpr size_t COUNT = 1U << 20U;
+
+    String* const small = String::allocate_small_utf8(u8"falafel");
+    String* const large = String::allocate_immortal_utf8(
+        u8"Chickpeas, parsley, garlic, cumin and coriander, fried until golden."
+    );
+
+    run("string_add_small", COUNT, [&] {
+        for (size_t i = 0U; i < COUNT; ++i) {
+            sink = small->add(small)->length();
+        }
+    });
+    run("string_add_large", COUNT, [&] {
+        for (size_t i = 0U; i < COUNT; ++i) {
+            sink = large->add(large)->length();
+        }
+    });
+
+    // The kind of string an interpolation builds: literal text with a few values spliced in.
+    run("stringbuilder_build", COUNT, [&] {
+        for (size_t i = 0U; i < COUNT; ++i) {
+            StringBuilder sb(large->length() + 32U);
+            sb.add_piece(large);
+            sb.add_bytes(u8" x", 2U);
+            sb.add_piece(static_cast<Int>(i));
+            sb.add_piece(u8' ');
+            sb.add_piece(small);
+            sink = sb.build()->length();
+        }
+    });
+}
+
+static void bench_type_info()
+{
+    constexpr size_t COUNT = 1U << 24U;
+
+    RcPointer<Object> string = String::allocate_small_utf8(u8"String");
+    RcPointer<Object> object = new Object();
+    Object* volatile objects[] = { string, object };
+    const TypeInfo& string_info = get_type_info<String>();
+
+    run("typeinfo_is_equal", COUNT, [&] {
+        size_t matches = 0U;
+        for (size_t i = 0U; i < COUNT; ++i) {
+            matches += objects[i & 1U]->get_type_info_dynamic().is_equal(string_info);
+        }
+        sink = matches;
+    });
+    run("typeinfo_downcast", COUNT, [&] {
+        size_t matches = 0U;
+        for (size_t i = 0U; i < COUNT; ++i) {
+            matches += falafel_internal::downcast<String>(objects[i & 1U]) != nullptr;
+        }
+        sink = matches;
+    });
+}
+
+int main()
+{
+    bench_refcounting();
+    bench_collect_cycles();
+    bench_cow_buffer();
+    bench_strings();
+    bench_type_info();
+}
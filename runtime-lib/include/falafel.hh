@@ -1,7 +1,16 @@
 #pragma once
 
+// The build precompiles this header for the default flags. GCC won't use those precompiled versions
+// in a file compiled with this macro defined, which is needed where they cause problems (e.g. GCC 12
+// crashes when using them in an instrumented PGO build).
+#ifdef FALAFEL_NO_PCH
+#endif
+
 #include "falafel/array.hh"
+#include "falafel/async.hh"
+#include "falafel/input.hh"
 #include "falafel/optional.hh"
+#include "falafel/parallel.hh"
 #include "falafel/refcount.hh"
 #include "falafel/string.hh"
 #include "falafel/stringbuilder.hh"
@@ -0,0 +1 @@
+../../src/async.hh
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/heapprofile.hh
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/input.hh
\ No newline at end of file
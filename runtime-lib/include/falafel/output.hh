@@ -0,0 +1 @@
+../../src/output.hh
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/parallel.hh
\ No newline at end of file
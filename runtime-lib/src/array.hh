@@ -1,7 +1,6 @@
 #pragma once
 
 #include "cow.hh"
-#include "mallocator.hh"
 #include "panic.hh"
 #include "typedefs.hh"
 #include "typeinfo.hh"
@@ -9,23 +8,11 @@
 #include <cstring>
 #include <functional>
 #include <new>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 
 class String;
 
-namespace falafel_internal {
-extern std::unordered_map<
-    TypeInfo, TypeInfo, std::hash<TypeInfo>, falafel_internal::MethodEquality<TypeInfo>,
-    falafel_internal::Mallocator<std::pair<const TypeInfo, TypeInfo>>
->
-    array_typeinfos;
-
-extern String* const array_str;
-
-const TypeInfo& make_array_info(const TypeInfo& element_info);
-}
-
 template<typename T>
 struct Array final {
 public:
@@ -92,19 +79,35 @@ public:
 
     size_t length() const noexcept { return m_buffer.length(); }
 
+    // For `for` loops, which iterate over their own copy of the array. Any change made to the
+    // original while the loop runs copies the buffer first, so these pointers stay valid.
+    const T* begin() const noexcept { return m_buffer.base_pointer(); }
+    const T* end() const noexcept { return m_buffer.base_pointer() + length(); }
+
+    // Makes this array hold `length` elements without initializing them, and returns where they go.
+    // Only for element types that need no construction, whose values the caller then writes.
+    T* resize_for_overwrite(size_t length)
+        requires std::is_trivial_v<T>
+    {
+        if (length == 0U) {
+            clear();
+            return nullptr;
+        }
+        m_buffer.ensure_unique(length);
+        m_buffer.length_mut() = length;
+        return m_buffer.base_pointer();
+    }
+
     void visit_children(std::function<void(Object*)> visitor) { visitor(m_buffer); }
 
     void clear() { m_buffer.clear(); }
 
-    static const TypeInfo& get_type_info_static()
+    static constexpr auto type_name = falafel_internal::FixedString(u8"Array<")
+        + falafel_internal::type_name<T> + falafel_internal::FixedString(u8">");
+
+    static const TypeInfo& get_type_info_static() noexcept
     {
-        const TypeInfo& element_info = get_type_info<T>();
-        auto iter = falafel_internal::array_typeinfos.find(element_info);
-        if (iter != falafel_internal::array_typeinfos.end()) {
-            return iter->second;
-        } else {
-            return falafel_internal::make_array_info(element_info);
-        }
+        return falafel_internal::StaticTypeInfo<Array<T>>::info;
     }
 
     Int f_lengthib() const noexcept { return static_cast<Int>(length()); }
@@ -114,5 +117,5 @@ public:
     Void f_pushvh(const T& el) { push(el); }
 
 private:
-    CowBuffer<T> m_buffer;
+    CowBuffer<T, Array<T>> m_buffer;
 };
@@ -0,0 +1,260 @@
+#include "async.hh"
+#include "heapprofile.hh"
+#include "input.hh"
+#include "output.hh"
+#include "panic.hh"
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <sys/epoll.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+// Frame sizes are rounded up to a multiple of this, and each multiple up to the largest pooled
+// size has its own free list. Larger frames go straight to malloc.
+constexpr size_t FRAME_GRANULARITY = 64U;
+constexpr size_t MAX_POOLED_FRAME_SIZE = 1024U;
+
+struct FreeFrame {
+    FreeFrame* next;
+};
+
+FreeFrame* free_frames[MAX_POOLED_FRAME_SIZE / FRAME_GRANULARITY] = {};
+
+constexpr size_t size_class(size_t size) noexcept { return (size - 1U) / FRAME_GRANULARITY; }
+
+struct Timer {
+    Clock::time_point deadline;
+    // Timers that expire at the same time fire in the order they were set.
+    uint64_t sequence;
+    std::coroutine_handle<> handle;
+
+    bool operator>(const Timer& other) const noexcept
+    {
+        return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+    }
+};
+
+constexpr int MAX_EVENTS = 64;
+
+class EventLoop {
+public:
+    ~EventLoop() noexcept
+    {
+        if (m_epoll >= 0) {
+            close(m_epoll);
+        }
+    }
+
+    void schedule(std::coroutine_handle<> handle) { m_ready.push_back(handle); }
+
+    void add_timer(Clock::time_point deadline, std::coroutine_handle<> handle)
+    {
+        m_timers.push(Timer { deadline, m_timer_sequence, handle });
+        ++m_timer_sequence;
+    }
+
+    void add_reader(int fd, std::coroutine_handle<> handle)
+    {
+        std::vector<std::coroutine_handle<>>& waiters = m_readers[fd];
+        waiters.push_back(handle);
+        if (waiters.size() > 1U) {
+            return;
+        }
+
+        // One-shot, so the descriptor is disarmed once it reports readiness and stays quiet until
+        // someone waits on it again. It stays registered meanwhile, hence the retry with MOD.
+        epoll_event event {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.fd = fd;
+        int result = epoll_ctl(epoll_fd(), EPOLL_CTL_ADD, fd, &event);
+        if (result < 0 && errno == EEXIST) {
+            result = epoll_ctl(epoll_fd(), EPOLL_CTL_MOD, fd, &event);
+        }
+        if (result < 0) {
+            // Regular files and the like can't be waited on, because reading them never blocks.
+            if (errno == EPERM) {
+                m_readers.erase(fd);
+                schedule(handle);
+                return;
+            }
+            throw std::system_error(errno, std::generic_category());
+        }
+    }
+
+    bool run_once()
+    {
+        // Nothing is being constructed between rounds, and a program that's only waiting for I/O
+        // allocates nothing else that would pick up a snapshot request.
+        falafel_internal::heap_profile_poll();
+        fire_expired_timers();
+        if (!m_ready.empty()) {
+            // Coroutines these resume are queued for the next round, after timers and I/O have had
+            // another look.
+            std::deque<std::coroutine_handle<>> batch;
+            batch.swap(m_ready);
+            for (auto handle : batch) {
+                handle.resume();
+            }
+            return true;
+        }
+
+        if (m_timers.empty() && m_readers.empty()) {
+            return false;
+        }
+        wait_for_events(m_timers.empty() ? -1 : milliseconds_until(m_timers.top().deadline));
+        return true;
+    }
+
+private:
+    std::deque<std::coroutine_handle<>> m_ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> m_timers;
+    uint64_t m_timer_sequence = 0U;
+    std::unordered_map<int, std::vector<std::coroutine_handle<>>> m_readers;
+    int m_epoll = -1;
+
+    int epoll_fd()
+    {
+        if (m_epoll < 0) {
+            m_epoll = epoll_create1(EPOLL_CLOEXEC);
+            if (m_epoll < 0) {
+                throw std::system_error(errno, std::generic_category());
+            }
+        }
+        return m_epoll;
+    }
+
+    void fire_expired_timers()
+    {
+        if (m_timers.empty()) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        while (!m_timers.empty() && m_timers.top().deadline <= now) {
+            schedule(m_timers.top().handle);
+            m_timers.pop();
+        }
+    }
+
+    // Rounded up, since waking before the deadline would only mean waiting again.
+    static int milliseconds_until(Clock::time_point deadline) noexcept
+    {
+        auto remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) {
+            return 0;
+        }
+        auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+        return milliseconds < INT_MAX ? static_cast<int>(milliseconds) : INT_MAX;
+    }
+
+    void wait_for_events(int timeout)
+    {
+        epoll_event events[MAX_EVENTS];
+        int count = epoll_wait(epoll_fd(), events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                return;
+            }
+            throw std::system_error(errno, std::generic_category());
+        }
+
+        for (int i = 0; i < count; ++i) {
+            auto waiters = m_readers.extract(events[i].data.fd);
+            if (!waiters.empty()) {
+                for (auto handle : waiters.mapped()) {
+                    schedule(handle);
+                }
+            }
+        }
+    }
+};
+
+EventLoop event_loop;
+}
+
+void* falafel_internal::allocate_frame(size_t size)
+{
+    if (size > MAX_POOLED_FRAME_SIZE) {
+        return Object::operator new(size);
+    }
+
+    FreeFrame*& list = free_frames[size_class(size)];
+    if (list != nullptr) {
+        FreeFrame* frame = list;
+        list = frame->next;
+        return frame;
+    }
+    return Object::operator new((size_class(size) + 1U) * FRAME_GRANULARITY);
+}
+
+void falafel_internal::free_frame(void* frame, size_t size) noexcept
+{
+    if (size > MAX_POOLED_FRAME_SIZE) {
+        Object::operator delete(frame);
+        return;
+    }
+
+    FreeFrame*& list = free_frames[size_class(size)];
+    list = new (frame) FreeFrame { list };
+}
+
+void falafel_internal::schedule(std::coroutine_handle<> handle) { event_loop.schedule(handle); }
+
+bool falafel_internal::run_event_loop_once() { return event_loop.run_once(); }
+
+void falafel_internal::run_event_loop()
+{
+    while (event_loop.run_once()) { }
+}
+
+void falafel_internal::panic_unobserved(std::exception_ptr error) noexcept
+{
+    char message[256] = "Unhandled error in a task nobody awaited";
+    try {
+        std::rethrow_exception(std::move(error));
+    } catch (const std::exception& e) {
+        snprintf(message, sizeof message, "Unhandled error in a task nobody awaited: %s", e.what());
+    } catch (...) {
+        // Anything that isn't a std::exception has no message to add.
+    }
+    panic(message);
+}
+
+void falafel_internal::TimerAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    event_loop.add_timer(deadline, handle);
+}
+
+void falafel_internal::ReadableAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    event_loop.add_reader(fd, handle);
+}
+
+Task<Void> f_sleepS4Task1_ve(Int milliseconds)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(milliseconds);
+    co_await falafel_internal::TimerAwaiter { deadline };
+}
+
+// Only the start of a line is waited for. Once part of it has arrived, the rest should follow
+// shortly, so read_line blocks for it the way readLine does.
+Task<Optional<RcPointer<String>>> f_readLineAsyncS4Task1_osb()
+{
+    if (!falafel_internal::has_buffered_input()) {
+        // Make sure a prompt is visible before waiting for the user to answer it.
+        if (isatty(STDIN_FILENO)) {
+            falafel_internal::flush_output();
+        }
+        co_await falafel_internal::ReadableAwaiter { STDIN_FILENO };
+    }
+    co_return String::read_line();
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "optional.hh"
+#include "panic.hh"
+#include "refcount.hh"
+#include "string.hh"
+#include "typedefs.hh"
+#include "typeinfo.hh"
+#include "visitable.hh"
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Async functions are C++ coroutines returning a Task. They start running as soon as they're
+// called, and suspend when they await something that isn't done yet. A single-threaded event loop
+// resumes them once what they're waiting for has happened: another task finishing, a timer
+// expiring, or a file descriptor becoming readable.
+
+template<typename T>
+struct Task;
+
+namespace falafel_internal {
+// Coroutine frames come from free lists of a few size classes rather than from malloc, since a
+// program that overlaps many waits starts and finishes a great many of them. Like the event loop,
+// this is only used from the main thread.
+void* allocate_frame(size_t size);
+void free_frame(void* frame, size_t size) noexcept;
+
+// Queues a suspended coroutine to be resumed by the event loop.
+void schedule(std::coroutine_handle<> handle);
+
+// Resumes whatever is ready, or else waits for the next timer or I/O event. Returns false, without
+// waiting, if nothing is queued or pending.
+bool run_event_loop_once();
+
+// Runs until every coroutine has finished. The program does this before it exits.
+void run_event_loop();
+
+// Called when a task that failed is freed without anything having awaited it.
+[[noreturn]] void panic_unobserved(std::exception_ptr error) noexcept;
+
+// Suspends until `deadline` has passed.
+struct TimerAwaiter {
+    std::chrono::steady_clock::time_point deadline;
+
+    bool await_ready() const noexcept { return std::chrono::steady_clock::now() >= deadline; }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept { }
+};
+
+// Suspends until `fd` can be read from without blocking, or has reached end of file or an error.
+// Descriptors that epoll can't wait on, such as regular files, are always considered ready.
+struct ReadableAwaiter {
+    int fd;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept { }
+};
+
+// What a task shares with everything awaiting it: its result or error once there is one, and the
+// coroutines waiting for it. This is an object so that the cycle collector sees the references in the result,
+// and it reports the task's type so that the heap profiler charges it to the task.
+template<typename T>
+class TaskState final : public Object {
+    static constexpr bool holds_objects = std::is_convertible_v<T, Object*> || Visitable<T>;
+
+public:
+    TaskState() noexcept
+        requires holds_objects
+    {
+    }
+
+    // Nothing a primitive result holds can be part of a cycle.
+    TaskState() noexcept
+        requires(!holds_objects)
+        : Object(LeafMarker {})
+    {
+    }
+
+    ~TaskState() noexcept override
+    {
+        if (m_error) {
+            if (!m_observed) {
+                panic_unobserved(m_error);
+            }
+            return;
+        }
+        // If the collector already released what the result points to, running its destructor
+        // would release it a second time.
+        if (m_done && !(holds_objects && children_released())) {
+            m_result.~T();
+        }
+    }
+
+    bool is_done() const noexcept { return m_done; }
+
+    const T& result() const
+    {
+        if (m_error) [[unlikely]] {
+            m_observed = true;
+            std::rethrow_exception(m_error);
+        }
+        return m_result;
+    }
+
+    const TypeInfo& get_type_info_dynamic() const noexcept override
+    {
+        return get_type_info<Task<T>>();
+    }
+
+    void add_waiter(std::coroutine_handle<> handle) { m_waiters.push_back(handle); }
+
+    void complete(T value)
+    {
+        new (&m_result) T(std::move(value));
+        finish();
+    }
+
+    void fail(std::exception_ptr error)
+    {
+        m_error = std::move(error);
+        finish();
+    }
+
+protected:
+    void visit_children(std::function<void(Object*)> visitor) override
+    {
+        if (!m_done || m_error) {
+            return;
+        }
+        if constexpr (std::is_convertible_v<T, Object*>) {
+            visitor(m_result);
+        } else if constexpr (Visitable<T>) {
+            m_result.visit_children(visitor);
+        }
+    }
+
+private:
+    void finish()
+    {
+        m_done = true;
+        for (auto waiter : m_waiters) {
+            schedule(waiter);
+        }
+        m_waiters.clear();
+    }
+
+    union {
+        T m_result;
+    };
+    bool m_done = false;
+    mutable bool m_observed = false;
+    std::exception_ptr m_error;
+    std::vector<std::coroutine_handle<>> m_waiters;
+};
+
+template<>
+class TaskState<Void> final : public Object {
+public:
+    TaskState() noexcept : Object(LeafMarker {}) { }
+
+    ~TaskState() noexcept override
+    {
+        if (m_error && !m_observed) {
+            panic_unobserved(m_error);
+        }
+    }
+
+    bool is_done() const noexcept { return m_done; }
+
+    void result() const
+    {
+        if (m_error) [[unlikely]] {
+            m_observed = true;
+            std::rethrow_exception(m_error);
+        }
+    }
+
+    // Defined after Task.
+    const TypeInfo& get_type_info_dynamic() const noexcept override;
+
+    void add_waiter(std::coroutine_handle<> handle) { m_waiters.push_back(handle); }
+
+    void complete() { finish(); }
+
+    void fail(std::exception_ptr error)
+    {
+        m_error = std::move(error);
+        finish();
+    }
+
+private:
+    void finish()
+    {
+        m_done = true;
+        for (auto waiter : m_waiters) {
+            schedule(waiter);
+        }
+        m_waiters.clear();
+    }
+
+    bool m_done = false;
+    mutable bool m_observed = false;
+    std::exception_ptr m_error;
+    std::vector<std::coroutine_handle<>> m_waiters;
+};
+
+// A frame frees itself when its coroutine finishes, so it's only alive while there's work left.
+template<typename T>
+struct TaskPromiseBase {
+    RcPointer<TaskState<T>> state = new TaskState<T>();
+
+    static void* operator new(size_t size) { return allocate_frame(size); }
+    static void operator delete(void* frame, size_t size) noexcept { free_frame(frame, size); }
+
+    Task<T> get_return_object() noexcept { return Task<T>(state); }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+
+    // An error finishes the task like a result does, so the frame is still freed and its awaiters
+    // still resumed. Each await rethrows it, the same as a plain call would have.
+    void unhandled_exception() noexcept { state->fail(std::current_exception()); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase<T> {
+    void return_value(T value) { this->state->complete(std::move(value)); }
+};
+
+template<>
+struct TaskPromise<Void> : TaskPromiseBase<Void> {
+    void return_void() { state->complete(); }
+};
+}
+
+template<typename T>
+struct Task final {
+public:
+    using promise_type = falafel_internal::TaskPromise<T>;
+
+    explicit Task(RcPointer<falafel_internal::TaskState<T>> state) noexcept :
+        m_state(std::move(state))
+    {
+    }
+
+    bool is_done() const noexcept { return m_state->is_done(); }
+
+    // Every await gets its own copy of the result, since a task may be awaited any number of times.
+    auto operator co_await() const noexcept
+    {
+        struct Awaiter {
+            falafel_internal::TaskState<T>* state;
+
+            bool await_ready() const noexcept { return state->is_done(); }
+            void await_suspend(std::coroutine_handle<> handle) { state->add_waiter(handle); }
+            T await_resume() const { return state->result(); }
+        };
+        return Awaiter { m_state };
+    }
+
+    T result() const { return m_state->result(); }
+
+    static constexpr auto type_name = falafel_internal::FixedString(u8"Task<")
+        + falafel_internal::type_name<T> + falafel_internal::FixedString(u8">");
+
+    static const TypeInfo& get_type_info_static() noexcept
+    {
+        return falafel_internal::StaticTypeInfo<Task<T>>::info;
+    }
+
+    void visit_children(std::function<void(Object*)> visitor) { visitor(m_state); }
+
+private:
+    RcPointer<falafel_internal::TaskState<T>> m_state;
+};
+
+namespace falafel_internal {
+inline const TypeInfo& TaskState<Void>::get_type_info_dynamic() const noexcept
+{
+    return get_type_info<Task<Void>>();
+}
+
+// `await` outside of an async function: runs the event loop here until the task is done.
+template<typename T>
+T run_until_complete(const Task<T>& task)
+{
+    while (!task.is_done()) {
+        if (!run_event_loop_once()) [[unlikely]] {
+            panic("Awaited a task that can never finish");
+        }
+    }
+    return task.result();
+}
+}
+
+Task<Void> f_sleepS4Task1_ve(Int milliseconds);
+Task<Optional<RcPointer<String>>> f_readLineAsyncS4Task1_osb();
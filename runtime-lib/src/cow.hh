@@ -12,7 +12,9 @@
 #include <stdexcept>
 #include <type_traits>
 
-template<typename T>
+// `Owner` is the type whose values hold the buffer, if any. The heap profiler charges the buffer's
+// memory to it, so that an array's elements count towards the array.
+template<typename T, typename Owner = void>
     requires(!std::is_reference_v<T>)
 class CowBuffer final {
     static_assert(sizeof(char) == 1U);
@@ -26,7 +28,10 @@ private:
         ~Header() noexcept(std::is_nothrow_destructible_v<T>)
         {
             if constexpr (!std::is_trivially_destructible_v<T>) {
-                if (!is_destroyed()) [[likely]] {
+                // If the collector already released what the elements point to, running their
+                // destructors would release it a second time.
+                constexpr bool holds_objects = std::is_convertible_v<T, Object*> || Visitable<T>;
+                if (!is_destroyed() && !(holds_objects && children_released())) [[likely]] {
                     T* base_pointer
                         = reinterpret_cast<T*>(reinterpret_cast<char*>(this) + header_offset());
                     for (size_t i = 0U; i < m_length; ++i) {
@@ -36,6 +41,17 @@ private:
             }
         }
 
+        // Only the owner's name is needed here, so this doesn't depend on its TypeInfo, which
+        // can't be defined before String is.
+        const TypeInfo& get_type_info_dynamic() const noexcept override
+        {
+            if constexpr (std::is_void_v<Owner>) {
+                return Object::get_type_info_dynamic();
+            } else {
+                return falafel_internal::heap_profile_type_info(Owner::type_name.chars);
+            }
+        }
+
     protected:
         inline void visit_children(std::function<void(Object*)> visitor) final override
         {
@@ -60,7 +76,7 @@ public:
 
     CowBuffer(size_t capacity) : m_pointer(nullptr) { realloc(capacity); }
 
-    CowBuffer(const CowBuffer<T>& other) noexcept :
+    CowBuffer(const CowBuffer& other) noexcept :
         m_pointer(other.m_pointer), m_capacity(other.m_capacity)
     {
         if (m_pointer != nullptr) {
@@ -68,7 +84,7 @@ public:
         }
     }
 
-    CowBuffer(CowBuffer<T>&& other) noexcept :
+    CowBuffer(CowBuffer&& other) noexcept :
         m_pointer(other.m_pointer), m_capacity(other.m_capacity)
     {
         other.m_capacity = 0U;
@@ -82,8 +98,11 @@ public:
         }
     }
 
-    CowBuffer<T>& operator=(const CowBuffer<T>& other)
+    CowBuffer& operator=(const CowBuffer& other)
     {
+        if (this == &other) {
+            return *this;
+        }
         if (m_pointer != nullptr) {
             static_cast<Object*>(*this)->release();
         }
@@ -91,10 +110,13 @@ public:
         m_pointer = other.m_pointer;
         m_capacity = other.m_capacity;
 
-        static_cast<Object*>(*this)->retain();
+        if (m_pointer != nullptr) {
+            static_cast<Object*>(*this)->retain();
+        }
+        return *this;
     }
 
-    CowBuffer<T>& operator=(CowBuffer<T>&& other)
+    CowBuffer& operator=(CowBuffer&& other)
     {
         if (m_pointer != nullptr) {
             static_cast<Object*>(*this)->release();
@@ -105,6 +127,7 @@ public:
 
         other.m_pointer = nullptr;
         other.m_capacity = 0U;
+        return *this;
     }
 
     void ensure_unique(size_t capacity)
@@ -163,6 +186,10 @@ public:
             static_cast<Object*>(*this)->release();
             m_pointer = nullptr;
         } else {
+            // The heap profiler counts this as freeing the old block and allocating a new one.
+            if (falafel_internal::heap_profiling) [[unlikely]] {
+                falafel_internal::heap_profile_untrack(*this);
+            }
             void* old_header_ptr = static_cast<void*>(m_pointer - header_offset());
             void* realloc_ptr = ::realloc(old_header_ptr, total_size);
             if (realloc_ptr == nullptr) [[unlikely]] {
@@ -173,6 +200,9 @@ public:
                 }
             }
             m_pointer = reinterpret_cast<char*>(realloc_ptr) + header_offset();
+            if (falafel_internal::heap_profiling) [[unlikely]] {
+                falafel_internal::heap_profile_track(*this);
+            }
         }
 
         m_capacity = capacity;
@@ -209,12 +239,7 @@ public:
 
     void clear()
     {
-        if constexpr (!std::is_trivially_destructible_v<T>) {
-            for (size_t i = 0; i < length(); ++i) {
-                reinterpret_cast<T*>(m_pointer)[i].~T();
-            }
-        }
-
+        // The elements are destroyed along with the header once its last reference goes away.
         if (m_pointer != nullptr) {
             static_cast<Object*>(*this)->release();
             m_pointer = nullptr;
@@ -0,0 +1,364 @@
+#include "heapprofile.hh"
+#include "refcount.hh"
+#include "string.hh"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <execinfo.h>
+#include <malloc.h>
+#include <map>
+#include <random>
+#include <span>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+bool falafel_internal::heap_profiling = false;
+
+namespace {
+constexpr size_t DEFAULT_SAMPLE_RATE = 512U * 1024U;
+constexpr int MAX_STACK_DEPTH = 64;
+
+// Set by the signal handler and acted on at the next safe point.
+std::atomic<bool> snapshot_requested = false;
+
+struct Stack {
+    std::vector<void*> frames;
+    size_t allocated_count = 0U;
+    size_t allocated_bytes = 0U;
+    size_t live_count = 0U;
+    size_t live_bytes = 0U;
+};
+
+struct Sample {
+    size_t stack;
+    size_t bytes;
+};
+
+struct TypeTotals {
+    size_t count = 0U;
+    size_t bytes = 0U;
+};
+
+struct TypeInfoEqual {
+    bool operator()(const TypeInfo& a, const TypeInfo& b) const noexcept { return a.is_equal(b); }
+};
+
+void request_snapshot(int) { snapshot_requested.store(true, std::memory_order_relaxed); }
+}
+
+// Only used from the main thread. The parallel builtins' workers only handle primitives, so they
+// never create or free objects, and async tasks run on the main thread's event loop.
+struct HeapProfiler {
+    std::unordered_set<Object*> live;
+    std::unordered_map<Object*, Sample> samples;
+    std::vector<Stack> stacks;
+    std::map<std::vector<void*>, size_t> stack_indices;
+    std::mt19937_64 random { 0x6661'6C61'6665'6CULL };
+    std::exponential_distribution<double> sample_gap;
+    size_t sample_rate = 0U;
+    size_t bytes_until_sample = 0U;
+    const char* path_prefix = nullptr;
+    unsigned snapshot_count = 0U;
+    std::unordered_map<const char8_t*, TypeInfo> named_types;
+
+    void start(size_t rate)
+    {
+        sample_rate = std::max<size_t>(rate, 1U);
+        sample_gap = std::exponential_distribution<double>(1.0 / static_cast<double>(sample_rate));
+        bytes_until_sample = next_sample_gap();
+        // Loading the unwinder allocates, which mustn't happen while taking the first sample.
+        void* frame;
+        backtrace(&frame, 1);
+    }
+
+    void clear() noexcept
+    {
+        live.clear();
+        samples.clear();
+        stacks.clear();
+        stack_indices.clear();
+    }
+
+    size_t next_sample_gap() { return static_cast<size_t>(std::ceil(sample_gap(random))); }
+
+    // Samples are taken like tcmalloc's: a sample falls after an exponentially distributed number
+    // of bytes, so an allocation of n bytes is sampled with probability 1 - e^(-n / rate). pprof
+    // undoes that when it reads the profile.
+    __attribute__((noinline)) void maybe_sample(Object* obj, size_t bytes)
+    {
+        if (bytes < bytes_until_sample) {
+            bytes_until_sample -= bytes;
+            return;
+        }
+        bytes_until_sample = next_sample_gap();
+
+        void* frames[MAX_STACK_DEPTH];
+        int depth = backtrace(frames, MAX_STACK_DEPTH);
+        // Leave out this function, `track`, and heap_profile_track.
+        int skipped = std::min(depth, 3);
+        std::vector<void*> key(frames + skipped, frames + depth);
+
+        auto [it, inserted] = stack_indices.try_emplace(std::move(key), stacks.size());
+        if (inserted) {
+            stacks.push_back(Stack { .frames = it->first });
+        }
+        Stack& stack = stacks[it->second];
+        ++stack.allocated_count;
+        stack.allocated_bytes += bytes;
+        ++stack.live_count;
+        stack.live_bytes += bytes;
+        samples[obj] = Sample { it->second, bytes };
+    }
+
+    __attribute__((noinline)) void track(Object* obj)
+    {
+        poll();
+        live.insert(obj);
+        maybe_sample(obj, malloc_usable_size(obj));
+    }
+
+    void untrack(Object* obj) noexcept
+    {
+        live.erase(obj);
+        auto node = samples.extract(obj);
+        if (!node.empty()) {
+            Stack& stack = stacks[node.mapped().stack];
+            --stack.live_count;
+            stack.live_bytes -= node.mapped().bytes;
+        }
+    }
+
+    void poll()
+    {
+        if (snapshot_requested.exchange(false, std::memory_order_relaxed)) {
+            write_snapshot();
+        }
+    }
+
+    void write_snapshot()
+    {
+        if (path_prefix == nullptr) {
+            return;
+        }
+        unsigned index = snapshot_count++;
+        for (const char* extension : { "heap", "types" }) {
+            char path[4096];
+            snprintf(
+                path, sizeof path, "%s.%ld.%u.%s", path_prefix, static_cast<long>(getpid()), index,
+                extension
+            );
+            FILE* file = fopen(path, "w");
+            if (file == nullptr) {
+                perror(path);
+                continue;
+            }
+            if (extension[0] == 'h') {
+                write_pprof(file);
+            } else {
+                write_types(file);
+            }
+            fclose(file);
+        }
+    }
+
+    // The legacy text format that gperftools writes and pprof still reads, followed by the memory
+    // map pprof needs to symbolize the addresses.
+    void write_pprof(FILE* out)
+    {
+        Stack total;
+        for (const Stack& stack : stacks) {
+            total.allocated_count += stack.allocated_count;
+            total.allocated_bytes += stack.allocated_bytes;
+            total.live_count += stack.live_count;
+            total.live_bytes += stack.live_bytes;
+        }
+
+        fprintf(
+            out, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n", total.live_count,
+            total.live_bytes, total.allocated_count, total.allocated_bytes, sample_rate
+        );
+        for (const Stack& stack : stacks) {
+            fprintf(
+                out, "%zu: %zu [%zu: %zu] @", stack.live_count, stack.live_bytes,
+                stack.allocated_count, stack.allocated_bytes
+            );
+            for (void* frame : stack.frames) {
+                fprintf(out, " %p", frame);
+            }
+            fputc('\n', out);
+        }
+
+        fputs("\nMAPPED_LIBRARIES:\n", out);
+        FILE* maps = fopen("/proc/self/maps", "r");
+        if (maps != nullptr) {
+            char buffer[4096];
+            size_t length;
+            while ((length = fread(buffer, 1U, sizeof buffer, maps)) > 0U) {
+                fwrite(buffer, 1U, length, out);
+            }
+            fclose(maps);
+        }
+    }
+
+    void write_types(FILE* out)
+    {
+        std::unordered_map<TypeInfo, TypeTotals, std::hash<TypeInfo>, TypeInfoEqual> by_type;
+        TypeTotals total;
+        for (Object* obj : live) {
+            size_t bytes = heap_bytes(obj);
+            TypeTotals& totals = by_type[obj->get_type_info_dynamic()];
+            ++totals.count;
+            totals.bytes += bytes;
+            ++total.count;
+            total.bytes += bytes;
+        }
+
+        std::vector<std::pair<const TypeInfo*, TypeTotals>> rows;
+        for (const auto& [info, totals] : by_type) {
+            rows.emplace_back(&info, totals);
+        }
+        std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+            return a.second.bytes > b.second.bytes;
+        });
+
+        fprintf(out, "%zu live objects, %zu bytes\n\n", total.count, total.bytes);
+        fprintf(out, "%12s %14s  %s\n", "objects", "bytes", "type");
+        for (const auto& [info, totals] : rows) {
+            fprintf(out, "%12zu %14zu  ", totals.count, totals.bytes);
+            write_name(out, *info);
+            fputc('\n', out);
+        }
+
+        std::span<Object* const> roots = Object::buffered_roots();
+        fprintf(out, "\n%zu objects in the cycle collector's root buffer\n", roots.size());
+        for (Object* obj : roots) {
+            fprintf(out, "%18p %14zu  ", static_cast<void*>(obj), heap_bytes(obj));
+            write_name(out, obj->get_type_info_dynamic());
+            fputc('\n', out);
+        }
+    }
+
+    // The object's block, plus a string's characters when they were allocated separately.
+    static size_t heap_bytes(Object* obj) noexcept
+    {
+        size_t bytes = malloc_usable_size(obj);
+        const String* string = falafel_internal::downcast<String>(obj);
+        if (string != nullptr && !string->m_flags.is_small && !string->m_flags.is_immortal
+            && !string->m_flags.is_slice && !string->m_flags.is_embedded
+            && !string->m_flags.is_mapped) {
+            bytes += malloc_usable_size(string->m_data.char8_ptr);
+        }
+        return bytes;
+    }
+
+    const TypeInfo& type_info_named(const char8_t* name) noexcept
+    {
+        auto [it, inserted] = named_types.try_emplace(name);
+        if (inserted) {
+            size_t length = std::char_traits<char8_t>::length(name);
+            String::Data data;
+            data.char8_literal = name;
+            it->second.name = new String(
+                String::Flags {
+                    .is_small = false,
+                    .is_immortal = true,
+                    .is_slice = false,
+                    .is_embedded = false,
+                    .is_mapped = false,
+                },
+                data,
+                length,
+                ImmortalMarker {}
+            );
+            it->second.name_hash = falafel_internal::pjw_hash(name, length);
+        }
+        return it->second;
+    }
+
+    static void write_name(FILE* out, const TypeInfo& info)
+    {
+        fwrite(info.name->buffer_ptr(), 1U, info.name->length(), out);
+    }
+};
+
+namespace {
+HeapProfiler profiler;
+
+void snapshot_at_exit() noexcept
+{
+    try {
+        profiler.write_snapshot();
+    } catch (...) {
+        // Exiting matters more than the snapshot.
+    }
+}
+
+// Profiling is decided before main starts, so that no object the program creates is missed.
+[[maybe_unused]] const bool started_from_environment = [] {
+    const char* prefix = getenv("FALAFEL_HEAP_PROFILE");
+    if (prefix == nullptr || *prefix == '\0') {
+        return false;
+    }
+
+    size_t rate = DEFAULT_SAMPLE_RATE;
+    const char* rate_env = getenv("FALAFEL_HEAP_PROFILE_RATE");
+    if (rate_env != nullptr) {
+        char* end;
+        unsigned long long parsed = strtoull(rate_env, &end, 10);
+        if (*rate_env != '\0' && *end == '\0' && parsed > 0U) {
+            rate = static_cast<size_t>(parsed);
+        }
+    }
+
+    profiler.path_prefix = prefix;
+    falafel_internal::heap_profile_start(rate);
+    signal(SIGUSR1, request_snapshot);
+    atexit(snapshot_at_exit);
+    return true;
+}();
+}
+
+void falafel_internal::heap_profile_start(size_t sample_rate)
+{
+    profiler.start(sample_rate);
+    heap_profiling = true;
+}
+
+void falafel_internal::heap_profile_stop() noexcept
+{
+    heap_profiling = false;
+    profiler.clear();
+}
+
+// Losing track of an object only makes the profile less complete, which beats failing to construct
+// it, so this swallows allocation failures.
+void falafel_internal::heap_profile_track(Object* obj) noexcept
+{
+    try {
+        profiler.track(obj);
+    } catch (...) {
+    }
+}
+
+void falafel_internal::heap_profile_untrack(Object* obj) noexcept { profiler.untrack(obj); }
+
+void falafel_internal::heap_profile_poll()
+{
+    if (heap_profiling) {
+        profiler.poll();
+    }
+}
+
+const TypeInfo& falafel_internal::heap_profile_type_info(const char8_t* name) noexcept
+{
+    return profiler.type_info_named(name);
+}
+
+void falafel_internal::heap_profile_write_pprof(FILE* out) { profiler.write_pprof(out); }
+
+void falafel_internal::heap_profile_write_types(FILE* out) { profiler.write_types(out); }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+
+class Object;
+struct TypeInfo;
+
+// Opt-in heap profiling. Setting the FALAFEL_HEAP_PROFILE environment variable to a path prefix
+// turns it on at startup. A snapshot is then written on SIGUSR1 and at exit, each as two files:
+// `<prefix>.<pid>.<n>.heap`, sampled allocation stacks in the legacy pprof heap format, and
+// `<prefix>.<pid>.<n>.types`, every live object counted by type, followed by the objects waiting in
+// the cycle collector's root buffer. FALAFEL_HEAP_PROFILE_RATE sets the average number of bytes
+// between samples, 512 KiB by default.
+//
+// Every object that isn't immortal is tracked from its constructor to its destructor, and its type
+// is looked up when a snapshot is taken. Objects are assumed to sit at the start of a heap block,
+// which is the case for everything the runtime and generated code create, and are charged for the
+// whole block. An array's buffer is such an object, so its elements count towards Array<T>.
+
+namespace falafel_internal {
+// Whether profiling is on. When it is off, tracking costs a check of this flag per object.
+extern bool heap_profiling;
+
+// Starts profiling, taking a sample about every `sample_rate` bytes. Objects that already exist
+// aren't tracked, except for array buffers that are reallocated later.
+void heap_profile_start(size_t sample_rate);
+
+// Stops profiling and discards everything recorded.
+void heap_profile_stop() noexcept;
+
+// Called from Object's constructors and destructor while profiling, and around reallocating an
+// array's buffer.
+void heap_profile_track(Object* obj) noexcept;
+void heap_profile_untrack(Object* obj) noexcept;
+
+// Writes the snapshot a signal asked for, if any. Only call this where no object is partway through
+// construction or destruction, except ones whose constructor or destructor is on the call stack.
+void heap_profile_poll();
+
+// A TypeInfo named `name`, made the first time it is asked for, for objects that only know their
+// type's name. `name` has to stay valid for the life of the program.
+const TypeInfo& heap_profile_type_info(const char8_t* name) noexcept;
+
+// The two halves of a snapshot.
+void heap_profile_write_pprof(FILE* out);
+void heap_profile_write_types(FILE* out);
+}
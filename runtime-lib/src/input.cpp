@@ -0,0 +1,205 @@
+#include "input.hh"
+#include "output.hh"
+#include "stringbuilder.hh"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+static int argument_count = 0;
+static const char** argument_values = nullptr;
+
+void falafel_internal::set_arguments(int argc, const char** argv) noexcept
+{
+    argument_count = argc;
+    argument_values = argv;
+}
+
+Array<RcPointer<String>> f_argumentsasb()
+{
+    // argv lives until the program exits, so the strings can point straight into it.
+    static const Array<RcPointer<String>> arguments = [] {
+        size_t count = argument_count > 1 ? static_cast<size_t>(argument_count - 1) : 0U;
+        Array<RcPointer<String>> result(count);
+        for (size_t i = 0U; i < count; ++i) {
+            result.push(String::allocate_immortal_utf8(
+                reinterpret_cast<const char8_t*>(argument_values[i + 1U])
+            ));
+        }
+        return result;
+    }();
+
+    return arguments;
+}
+
+static size_t without_carriage_return(const char8_t* line, size_t length) noexcept
+{
+    return length > 0U && line[length - 1U] == u8'\r' ? length - 1U : length;
+}
+
+Optional<RcPointer<String>> LineIterator::next()
+{
+    size_t length = m_text->length();
+    if (m_offset >= length) {
+        return nullptr;
+    }
+
+    const char8_t* start = m_text->buffer_ptr() + m_offset;
+    size_t remaining = length - m_offset;
+    const void* newline = memchr(start, u8'\n', remaining);
+
+    size_t offset = m_offset;
+    size_t line_length;
+    if (newline == nullptr) {
+        line_length = remaining;
+        m_offset = length;
+    } else {
+        line_length = static_cast<size_t>(static_cast<const char8_t*>(newline) - start);
+        m_offset += line_length + 1U;
+    }
+
+    return m_text->slice(offset, without_carriage_return(start, line_length));
+}
+
+static constexpr size_t INPUT_BUFFER_SIZE = 65536U;
+
+static char8_t input_buffer[INPUT_BUFFER_SIZE];
+static size_t input_start = 0U;
+static size_t input_end = 0U;
+
+// Reads more of stdin into the (fully consumed) buffer. Returns false at end of input.
+static bool refill_input_buffer()
+{
+    // Make sure a prompt is visible before waiting for the user to answer it.
+    static const bool is_interactive = isatty(STDIN_FILENO);
+    if (is_interactive) {
+        falafel_internal::flush_output();
+    }
+
+    while (true) {
+        ssize_t length = read(STDIN_FILENO, input_buffer, sizeof input_buffer);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category());
+        }
+
+        input_start = 0U;
+        input_end = static_cast<size_t>(length);
+        return length > 0;
+    }
+}
+
+bool falafel_internal::has_buffered_input() noexcept { return input_start != input_end; }
+
+Optional<RcPointer<String>> String::read_line()
+{
+    if (input_start == input_end && !refill_input_buffer()) {
+        return nullptr;
+    }
+
+    const char8_t* start = input_buffer + input_start;
+    const void* newline = memchr(start, u8'\n', input_end - input_start);
+    if (newline != nullptr) [[likely]] {
+        size_t length = static_cast<size_t>(static_cast<const char8_t*>(newline) - start);
+        input_start += length + 1U;
+        return allocate_copy_utf8(start, without_carriage_return(start, length));
+    }
+
+    // The line continues past the end of the buffer.
+    StringBuilder sb(2U * (input_end - input_start));
+    while (newline == nullptr) {
+        sb.add_bytes(input_buffer + input_start, input_end - input_start);
+        input_start = input_end;
+        if (!refill_input_buffer()) {
+            break;
+        }
+        newline = memchr(input_buffer, u8'\n', input_end);
+    }
+
+    if (newline != nullptr) {
+        size_t length = static_cast<size_t>(static_cast<const char8_t*>(newline) - input_buffer);
+        sb.add_bytes(input_buffer, length);
+        input_start = length + 1U;
+    }
+
+    RcPointer<String> result = sb.build();
+    size_t length = without_carriage_return(result->buffer_ptr(), result->m_length);
+    if (length != result->m_length) {
+        return result->slice(0U, length);
+    }
+    return result;
+}
+
+// Below this size, reading a file is cheaper than setting up and tearing down a mapping.
+static constexpr size_t MIN_MAPPED_FILE_SIZE = 65536U;
+
+namespace {
+struct FileDescriptor {
+    int fd;
+
+    inline ~FileDescriptor() noexcept { close(fd); }
+};
+}
+
+Optional<RcPointer<String>> String::read_file(const String* path)
+{
+    std::string path_string(reinterpret_cast<const char*>(path->buffer_ptr()), path->m_length);
+    if (path_string.find('\0') != std::string::npos) {
+        return nullptr;
+    }
+
+    int fd;
+    do {
+        fd = open(path_string.c_str(), O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        return nullptr;
+    }
+    FileDescriptor file { .fd = fd };
+
+    struct stat info;
+    bool is_regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+
+    if (is_regular && static_cast<size_t>(info.st_size) >= MIN_MAPPED_FILE_SIZE) {
+        size_t length = static_cast<size_t>(info.st_size);
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            // Lines are usually processed front to back, so read ahead aggressively.
+            madvise(mapping, length, MADV_SEQUENTIAL);
+            return new String(
+                Flags {
+                    .is_small = false,
+                    .is_immortal = false,
+                    .is_slice = false,
+                    .is_embedded = false,
+                    .is_mapped = true,
+                },
+                Data { .char8_ptr = static_cast<char8_t*>(mapping) },
+                length
+            );
+        }
+    }
+
+    // Small files, pipes, and anything else that can't be mapped are read into memory.
+    StringBuilder sb(is_regular ? static_cast<size_t>(info.st_size) : 0U);
+    char8_t chunk[16384U];
+    while (true) {
+        ssize_t length = read(fd, chunk, sizeof chunk);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return nullptr;
+        }
+        if (length == 0) {
+            return sb.build();
+        }
+        sb.add_bytes(chunk, static_cast<size_t>(length));
+    }
+}
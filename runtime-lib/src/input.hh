@@ -0,0 +1,44 @@
+#pragma once
+
+#include "array.hh"
+#include "optional.hh"
+#include "refcount.hh"
+#include "string.hh"
+#include <cstddef>
+#include <functional>
+
+// Yields the lines of a string one at a time, without their line terminators. Lines are slices of
+// the original string, so iterating over a memory-mapped file never copies it.
+struct LineIterator final {
+public:
+    inline explicit LineIterator(String* text) noexcept : m_text(text), m_offset(0U)
+    {
+        text->retain();
+    }
+
+    // Returns null once every line has been returned.
+    Optional<RcPointer<String>> next();
+
+    inline Optional<RcPointer<String>> f_nextosb() { return next(); }
+
+    inline void visit_children(std::function<void(Object*)> visitor) { visitor(m_text); }
+
+private:
+    RcPointer<String> m_text;
+    size_t m_offset;
+};
+
+namespace falafel_internal {
+// Records the command-line arguments. Called first thing in main.
+void set_arguments(int argc, const char** argv) noexcept;
+
+// Whether String::read_line has input on hand already, so that it won't wait for more.
+bool has_buffered_input() noexcept;
+}
+
+// The command-line arguments, not including the program name.
+Array<RcPointer<String>> f_argumentsasb();
+
+inline Optional<RcPointer<String>> f_readLineosb() { return String::read_line(); }
+inline Optional<RcPointer<String>> f_readFileosf(String* path) { return String::read_file(path); }
+inline LineIterator f_linesS12LineIteratorf(String* text) { return LineIterator(text); }
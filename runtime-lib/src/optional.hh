@@ -34,6 +34,15 @@ public:
         return *this;
     }
 
+    static constexpr auto type_name
+        = falafel_internal::FixedString(u8"Optional<") + falafel_internal::type_name<T>
+        + falafel_internal::FixedString(u8">");
+
+    static const TypeInfo& get_type_info_static() noexcept
+    {
+        return falafel_internal::StaticTypeInfo<Optional<T>>::info;
+    }
+
     constexpr bool has_value() const noexcept { return m_value.has_value(); }
     constexpr bool f_hasValuebb() const noexcept { return has_value(); }
 
@@ -67,6 +76,15 @@ public:
     constexpr Optional(RcPointer<T>&& ptr) noexcept : m_value(ptr) { }
     constexpr Optional(T* ptr) noexcept : m_value(ptr) { }
 
+    static constexpr auto type_name
+        = falafel_internal::FixedString(u8"Optional<") + falafel_internal::type_name<T>
+        + falafel_internal::FixedString(u8">");
+
+    static const TypeInfo& get_type_info_static() noexcept
+    {
+        return falafel_internal::StaticTypeInfo<Optional<RcPointer<T>>>::info;
+    }
+
     constexpr bool has_value() const noexcept { return static_cast<T*>(m_value) != nullptr; }
     constexpr bool f_hasValuebb() const noexcept { return has_value(); }
 
@@ -0,0 +1,129 @@
+#include "output.hh"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+
+using falafel_internal::OutputMode;
+
+static constexpr size_t OUTPUT_BUFFER_SIZE = 65536U;
+
+static char8_t output_buffer[OUTPUT_BUFFER_SIZE];
+static size_t buffered_length = 0U;
+static OutputMode output_mode = OutputMode::line_buffered;
+static bool is_initialized = false;
+
+// Writes every byte described by `iov`, retrying on interrupts and short writes.
+static void write_all(iovec* iov, int count)
+{
+    while (count > 0) {
+        ssize_t written = writev(STDOUT_FILENO, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category());
+        }
+
+        size_t remaining = static_cast<size_t>(written);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+}
+
+static void flush_at_exit() noexcept
+{
+    try {
+        falafel_internal::flush_output();
+    } catch (const std::system_error& e) {
+        // Exiting successfully would hide the lost output.
+        fprintf(stderr, "Failed to write output: %s\n", e.what());
+        _Exit(EXIT_FAILURE);
+    }
+}
+
+static void initialize(OutputMode mode)
+{
+    output_mode = mode;
+    if (!is_initialized) {
+        is_initialized = true;
+        atexit(flush_at_exit);
+    }
+}
+
+static OutputMode default_mode() noexcept
+{
+    const char* env = getenv("FALAFEL_STDOUT");
+    if (env != nullptr) {
+        if (strcmp(env, "line") == 0) {
+            return OutputMode::line_buffered;
+        }
+        if (strcmp(env, "full") == 0) {
+            return OutputMode::fully_buffered;
+        }
+    }
+
+    return isatty(STDOUT_FILENO) ? OutputMode::line_buffered : OutputMode::fully_buffered;
+}
+
+void falafel_internal::set_output_mode(OutputMode mode)
+{
+    flush_output();
+    initialize(mode);
+}
+
+void falafel_internal::write_line(const char8_t* bytes, size_t length)
+{
+    if (!is_initialized) [[unlikely]] {
+        initialize(default_mode());
+    }
+
+    if (output_mode == OutputMode::fully_buffered
+        && length < OUTPUT_BUFFER_SIZE - buffered_length) {
+        memcpy(output_buffer + buffered_length, bytes, length * sizeof(char8_t));
+        output_buffer[buffered_length + length] = u8'\n';
+        buffered_length += length + 1U;
+        return;
+    }
+
+    // Either the line doesn't fit or it must be written immediately. Write the pending output, the
+    // line, and its newline with one system call, without copying the line into the buffer.
+    char8_t newline = u8'\n';
+    iovec iov[] = {
+        { .iov_base = output_buffer, .iov_len = buffered_length },
+        { .iov_base = const_cast<char8_t*>(bytes), .iov_len = length },
+        { .iov_base = &newline, .iov_len = 1U },
+    };
+    buffered_length = 0U;
+    write_all(iov, sizeof iov / sizeof iov[0]);
+}
+
+void falafel_internal::flush_output()
+{
+    if (buffered_length == 0U) {
+        return;
+    }
+
+    iovec iov = { .iov_base = output_buffer, .iov_len = buffered_length };
+    buffered_length = 0U;
+    write_all(&iov, 1);
+}
+
+void falafel_internal::flush_output_noexcept() noexcept
+{
+    try {
+        flush_output();
+    } catch (...) {
+        // The caller is already failing; there is nowhere to report this.
+    }
+}
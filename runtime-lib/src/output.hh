@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+namespace falafel_internal {
+enum class OutputMode : unsigned char {
+    // Every line is written as soon as it is printed.
+    line_buffered,
+    // Lines are collected in a private buffer and written when it fills up or at exit.
+    fully_buffered,
+};
+
+// Overrides the mode chosen at startup. By default, stdout is line-buffered when it is a terminal
+// and fully buffered otherwise; the FALAFEL_STDOUT environment variable ("line" or "full") takes
+// precedence over that. Pending output is flushed before the mode changes.
+void set_output_mode(OutputMode mode);
+
+// Writes `length` bytes followed by a newline to stdout. Throws std::system_error if the write
+// fails.
+void write_line(const char8_t* bytes, size_t length);
+
+// Writes any buffered output. Throws std::system_error if the write fails.
+void flush_output();
+
+// Like `flush_output`, but ignores errors. Used when the program is about to abort.
+void flush_output_noexcept() noexcept;
+}
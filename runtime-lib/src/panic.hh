@@ -1,10 +1,12 @@
 #pragma once
 
+#include "output.hh"
 #include <cstdio>
 #include <cstdlib>
 
 [[noreturn]] inline void panic(const char* message) noexcept
 {
+    falafel_internal::flush_output_noexcept();
     fprintf(stderr, "%s\n", message);
     fflush(stderr);
     abort();
@@ -0,0 +1,178 @@
+#include "parallel.hh"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+// The units one thread starts out with. Its owner claims them from the front, and so does any
+// thread that runs out of its own and steals from it, so each unit is claimed exactly once.
+struct alignas(64) Share {
+    std::atomic<size_t> next;
+    size_t end;
+};
+
+struct Job {
+    void (*body)(void*, size_t, size_t);
+    void* context;
+    size_t count;
+    size_t grain;
+    Share* shares;
+    size_t share_count;
+
+    void run_unit(size_t unit) const
+    {
+        size_t begin = unit * grain;
+        body(context, begin, std::min(begin + grain, count));
+    }
+
+    // Works through the units owned by `participant`, then steals from the others in turn.
+    void work(size_t participant) const
+    {
+        for (size_t i = 0U; i < share_count; ++i) {
+            Share& share = shares[(participant + i) % share_count];
+            for (;;) {
+                size_t unit = share.next.fetch_add(1U, std::memory_order_relaxed);
+                if (unit >= share.end) {
+                    break;
+                }
+                run_unit(unit);
+            }
+        }
+    }
+};
+
+thread_local bool is_worker = false;
+
+// How many threads share the work, counting the main one: one per hardware thread, unless the
+// FALAFEL_THREADS environment variable is a positive number.
+size_t thread_count() noexcept
+{
+    const char* env = getenv("FALAFEL_THREADS");
+    if (env != nullptr) {
+        char* end;
+        unsigned long count = strtoul(env, &end, 10);
+        if (*env != '\0' && *end == '\0' && count > 0U) {
+            return count;
+        }
+    }
+
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0U ? hardware : 1U;
+}
+
+// Worker threads besides the main one, started on first use. Workers sleep while there is no job.
+class Pool {
+public:
+    Pool()
+    {
+        size_t worker_count = thread_count() - 1U;
+        m_shares = std::make_unique<Share[]>(worker_count + 1U);
+        m_workers.reserve(worker_count);
+        for (size_t i = 0U; i < worker_count; ++i) {
+            m_workers.emplace_back([this, i] { run_worker(i + 1U); });
+        }
+    }
+
+    ~Pool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    size_t participant_count() const noexcept { return m_workers.size() + 1U; }
+
+    void run(size_t count, size_t grain, void (*body)(void*, size_t, size_t), void* context)
+    {
+        size_t unit_count = (count + grain - 1U) / grain;
+        size_t share_count = participant_count();
+        for (size_t i = 0U; i < share_count; ++i) {
+            m_shares[i].next.store(unit_count * i / share_count, std::memory_order_relaxed);
+            m_shares[i].end = unit_count * (i + 1U) / share_count;
+        }
+
+        Job job { body, context, count, grain, m_shares.get(), share_count };
+        {
+            std::lock_guard lock(m_mutex);
+            m_job = &job;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        job.work(0U);
+
+        // Every unit has been claimed, but workers may still be running theirs. Workers only join
+        // a job under the lock, so none can start on this one once it's withdrawn.
+        std::unique_lock lock(m_mutex);
+        m_job = nullptr;
+        m_idle.wait(lock, [this] { return m_active == 0U; });
+    }
+
+private:
+    void run_worker(size_t participant)
+    {
+        is_worker = true;
+        uint64_t seen = 0U;
+        std::unique_lock lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] {
+                return m_stopping || (m_job != nullptr && m_generation != seen);
+            });
+            if (m_stopping) {
+                return;
+            }
+            seen = m_generation;
+            const Job* job = m_job;
+            ++m_active;
+            lock.unlock();
+
+            job->work(participant);
+
+            lock.lock();
+            if (--m_active == 0U) {
+                m_idle.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Share[]> m_shares;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    const Job* m_job = nullptr;
+    uint64_t m_generation = 0U;
+    size_t m_active = 0U;
+    bool m_stopping = false;
+};
+}
+
+void falafel_internal::parallel_for(
+    size_t count, size_t grain, void (*body)(void* context, size_t begin, size_t end), void* context
+)
+{
+    if (count <= grain || is_worker) {
+        if (count > 0U) {
+            body(context, 0U, count);
+        }
+        return;
+    }
+
+    static Pool pool;
+    if (pool.participant_count() == 1U) {
+        body(context, 0U, count);
+        return;
+    }
+    pool.run(count, grain, body, context);
+}
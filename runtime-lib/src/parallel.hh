@@ -0,0 +1,110 @@
+#pragma once
+
+#include "array.hh"
+#include "typedefs.hh"
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace falafel_internal {
+// Indices per unit of work. Units are what threads claim and steal, and what reductions combine, so
+// their size depends only on the input and results don't depend on the number of threads.
+constexpr size_t PARALLEL_GRAIN = 4096U;
+
+// Calls `body(context, begin, end)` for consecutive units of `grain` indices covering [0, count),
+// spread over a pool of worker threads that the calling thread joins. Returns once every unit is
+// done. A range of one unit, or a call from inside a worker, runs entirely on the calling thread.
+void parallel_for(
+    size_t count, size_t grain, void (*body)(void* context, size_t begin, size_t end), void* context
+);
+
+template<typename F>
+void parallel_for(size_t count, size_t grain, F& body)
+{
+    parallel_for(
+        count,
+        grain,
+        [](void* context, size_t begin, size_t end) { (*static_cast<F*>(context))(begin, end); },
+        &body
+    );
+}
+
+// Elements are primitives, so threads share no reference counts: the input is only read, and each
+// thread writes its own part of a result buffer that nothing else can see yet.
+template<typename T>
+Array<T> parallel_map(const Array<T>& array, T (*function)(T))
+{
+    size_t length = array.length();
+    Array<T> result;
+    T* out = result.resize_for_overwrite(length);
+    const T* in = array.begin();
+
+    auto body = [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = function(in[i]);
+        }
+    };
+    parallel_for(length, PARALLEL_GRAIN, body);
+    return result;
+}
+
+// Each unit is reduced on its own, then the partial results are combined in order, so `function`
+// has to be associative but needn't be commutative.
+template<typename T>
+T parallel_reduce(const Array<T>& array, std::type_identity_t<T> initial, T (*function)(T, T))
+{
+    size_t length = array.length();
+    size_t unit_count = (length + PARALLEL_GRAIN - 1U) / PARALLEL_GRAIN;
+    std::unique_ptr<T[]> partials(new T[unit_count]);
+    const T* in = array.begin();
+
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t unit = begin; unit < end; ++unit) {
+            size_t first = unit * PARALLEL_GRAIN;
+            size_t last = first + PARALLEL_GRAIN < length ? first + PARALLEL_GRAIN : length;
+            T partial = in[first];
+            for (size_t i = first + 1U; i < last; ++i) {
+                partial = function(partial, in[i]);
+            }
+            partials[unit] = partial;
+        }
+    };
+    parallel_for(unit_count, 1U, body);
+
+    T result = initial;
+    for (size_t unit = 0U; unit < unit_count; ++unit) {
+        result = function(result, partials[unit]);
+    }
+    return result;
+}
+}
+
+inline Array<Int> f_parallelMapai0(const Array<Int>& array, Int (*function)(Int))
+{
+    return falafel_internal::parallel_map(array, function);
+}
+inline Array<Double> f_parallelMapad0(const Array<Double>& array, Double (*function)(Double))
+{
+    return falafel_internal::parallel_map(array, function);
+}
+inline Array<Float> f_parallelMapaf0(const Array<Float>& array, Float (*function)(Float))
+{
+    return falafel_internal::parallel_map(array, function);
+}
+
+inline Int f_parallelReduceib9(const Array<Int>& array, Int initial, Int (*function)(Int, Int))
+{
+    return falafel_internal::parallel_reduce(array, initial, function);
+}
+inline Double f_parallelReducedb9(
+    const Array<Double>& array, Double initial, Double (*function)(Double, Double)
+)
+{
+    return falafel_internal::parallel_reduce(array, initial, function);
+}
+inline Float f_parallelReducefb9(
+    const Array<Float>& array, Float initial, Float (*function)(Float, Float)
+)
+{
+    return falafel_internal::parallel_reduce(array, initial, function);
+}
@@ -5,7 +5,7 @@
 
 static_assert(MAX_NUM_ROOTS <= PTRDIFF_MAX);
 
-static const TypeInfo object_info = TypeInfo { .name = String::allocate_small_utf8(u8"Object") };
+static constexpr const TypeInfo& object_info = falafel_internal::StaticTypeInfo<Object>::info;
 
 static size_t num_roots = 0U;
 
@@ -15,6 +15,9 @@ Object::~Object() noexcept
         panic("Destroying buffered root");
     }
     m_destroyed = true;
+    if (falafel_internal::heap_profiling) [[unlikely]] {
+        falafel_internal::heap_profile_untrack(this);
+    }
 }
 
 const TypeInfo& Object::get_type_info_static() noexcept { return object_info; }
@@ -22,20 +25,23 @@ const TypeInfo& Object::get_type_info_dynamic() const noexcept { return object_i
 
 RcPointer<String> Object::f_toStringsb()
 {
-    StringBuilder sb(3U);
-    sb.add_piece(u8'<');
-    sb.add_piece(get_type_info_dynamic().name);
-
+    const String* name = get_type_info_dynamic().name;
     char pointer_string[21U];
     size_t length
         = snprintf(pointer_string, sizeof pointer_string, ":%p>", static_cast<void*>(this));
-    sb.add_runtime_allocated_piece(pointer_string, length);
+
+    StringBuilder sb(name->length() + length + 1U);
+    sb.add_piece(u8'<');
+    sb.add_piece(name);
+    sb.add_bytes(reinterpret_cast<const char8_t*>(pointer_string), length);
 
     return sb.build();
 }
 
 void Object::visit_children(std::function<void(Object*)>) { }
 
+std::span<Object* const> Object::buffered_roots() noexcept { return { roots, num_roots }; }
+
 void Object::retain() noexcept
 {
     if (m_destroyed) [[unlikely]] {
@@ -70,6 +76,7 @@ void Object::release()
                 child->release();
             }
         });
+        m_children_released = true;
         m_color = ObjectColor::black;
         if (!m_buffered) {
             delete this;
@@ -157,6 +164,7 @@ void Object::collect_white()
                 child->collect_white();
             }
         });
+        m_children_released = true;
         delete this;
         return;
     }
@@ -5,11 +5,15 @@
 // part (which involves red and orange nodes) is not implemented as programs are currently always
 // single-threaded.
 
+#include "heapprofile.hh"
 #include "typeinfo.hh"
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
 
 constexpr size_t MAX_NUM_ROOTS = 1024U;
 
@@ -24,6 +28,39 @@ enum class ObjectColor : unsigned char {
 struct ImmortalMarker { };
 struct LeafMarker { };
 
+/**
+ * Storage for a constant-initialized immortal object with static storage duration. The wrapped
+ * object's destructor is never run, so it stays valid while other static destructors run.
+ */
+template<typename T>
+union ImmortalStorage {
+    T value;
+
+    template<typename... Args>
+    constexpr ImmortalStorage(Args&&... args) noexcept : value(std::forward<Args>(args)...)
+    {
+    }
+
+    constexpr ~ImmortalStorage() noexcept { }
+};
+
+namespace falafel_internal {
+// Checked downcast in place of dynamic_cast: an object is a T exactly when its class ID falls in
+// T's range. Returns null if `obj` is null or isn't a T.
+template<typename T, typename U>
+T* downcast(U* obj) noexcept
+{
+    if constexpr (std::is_base_of_v<T, U>) {
+        return obj;
+    } else {
+        if (obj != nullptr && T::class_ids.contains(obj->get_type_info_dynamic().class_ids.first)) {
+            return static_cast<T*>(obj);
+        }
+        return nullptr;
+    }
+}
+}
+
 template<typename T>
 class RcPointer final {
 public:
@@ -42,7 +79,8 @@ public:
     RcPointer(RcPointer<T>&& other) noexcept : m_obj(other.m_obj) { other.m_obj = nullptr; }
 
     template<typename U>
-    explicit RcPointer(const RcPointer<U>& other) : m_obj(dynamic_cast<T*>(static_cast<U*>(other)))
+    explicit RcPointer(const RcPointer<U>& other) noexcept :
+        m_obj(falafel_internal::downcast<T>(static_cast<U*>(other)))
     {
         if (m_obj != nullptr) {
             m_obj->retain();
@@ -50,9 +88,13 @@ public:
     }
 
     template<typename U>
-    explicit RcPointer(RcPointer<U>&& other) : m_obj(dynamic_cast<T*>(static_cast<U*>(other)))
+    explicit RcPointer(RcPointer<U>&& other) noexcept :
+        m_obj(falafel_internal::downcast<T>(static_cast<U*>(other)))
     {
-        other.null_without_release();
+        // On failure, `other` keeps its reference and drops it as usual.
+        if (m_obj != nullptr) {
+            other.null_without_release();
+        }
     }
 
     ~RcPointer()
@@ -97,6 +139,11 @@ private:
     T* m_obj;
 };
 
+namespace falafel_internal {
+template<typename T>
+constexpr auto type_name<RcPointer<T>> = type_name<T>;
+}
+
 class String;
 
 class Object {
@@ -134,24 +181,46 @@ public:
 
     static void collect_cycles();
 
+    // The possible cycle roots that the next collection will start from.
+    static std::span<Object* const> buffered_roots() noexcept;
+
     constexpr Object() noexcept :
-        m_refcount(1U), m_color(ObjectColor::black), m_buffered(false), m_destroyed(false)
+        m_refcount(1U),
+        m_color(ObjectColor::black),
+        m_buffered(false),
+        m_destroyed(false),
+        m_children_released(false)
     {
+        profile_construction();
     }
 
     constexpr Object(ImmortalMarker) noexcept :
-        m_refcount(UINTPTR_MAX), m_color(ObjectColor::black), m_buffered(false), m_destroyed(false)
+        m_refcount(UINTPTR_MAX),
+        m_color(ObjectColor::black),
+        m_buffered(false),
+        m_destroyed(false),
+        m_children_released(false)
     {
     }
 
     constexpr Object(LeafMarker) noexcept :
-        m_refcount(1U), m_color(ObjectColor::green), m_buffered(false), m_destroyed(false)
+        m_refcount(1U),
+        m_color(ObjectColor::green),
+        m_buffered(false),
+        m_destroyed(false),
+        m_children_released(false)
     {
+        profile_construction();
     }
 
     Object(const Object&) = delete;
     virtual ~Object() noexcept;
 
+    static constexpr falafel_internal::FixedString type_name { u8"Object" };
+    static constexpr falafel_internal::ClassIdRange class_ids {
+        falafel_internal::ClassId::object, falafel_internal::ClassId::string
+    };
+
     static const TypeInfo& get_type_info_static() noexcept;
     virtual const TypeInfo& get_type_info_dynamic() const noexcept;
 
@@ -167,15 +236,29 @@ protected:
 protected:
     constexpr bool is_destroyed() const noexcept { return m_destroyed; }
 
+    /**
+     * Whether the references held by this object were already dropped by the collector, in which
+     * case the destructor must not drop them a second time.
+     */
+    constexpr bool children_released() const noexcept { return m_children_released; }
+
 private:
     uintptr_t m_refcount;
     ObjectColor m_color : 3;
     bool m_buffered : 1;
     bool m_destroyed : 1;
+    bool m_children_released : 1;
 
     static inline Object* roots[MAX_NUM_ROOTS];
     void buffer_root();
 
+    constexpr void profile_construction() noexcept
+    {
+        if (!std::is_constant_evaluated() && falafel_internal::heap_profiling) [[unlikely]] {
+            falafel_internal::heap_profile_track(this);
+        }
+    }
+
     void mark_gray();
     void scan_gray();
     void scan_black();
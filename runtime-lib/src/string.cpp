@@ -1,18 +1,33 @@
 #include "string.hh"
+#include "max.hh"
+#include "output.hh"
 #include "panic.hh"
-#include <cerrno>
-#include <cstdio>
+#include <bit>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
-#include <system_error>
+#include <sys/mman.h>
 
-String* const String::empty = String::allocate_small_utf8(u8"");
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-static const TypeInfo string_info = TypeInfo { .name = String::allocate_small_utf8(u8"String") };
+static constinit ImmortalStorage<String> empty_storage(u8"");
+
+String* const String::empty = &empty_storage.value;
+
+static constexpr const TypeInfo& string_info = falafel_internal::StaticTypeInfo<String>::info;
 
 String::~String() noexcept
 {
     if (!is_destroyed()) [[likely]] {
-        if (!m_flags.is_immortal && !m_flags.is_small) {
+        if (m_flags.is_slice) {
+            m_data.slice.parent->release();
+        } else if (m_flags.is_mapped) {
+            munmap(m_data.char8_ptr, m_length);
+        } else if (!m_flags.is_immortal && !m_flags.is_small && !m_flags.is_embedded) {
             free(m_data.char8_ptr);
         }
     }
@@ -33,12 +48,43 @@ String* String::allocate_runtime_utf8(size_t length)
     }
 
     return new String(
-        Flags { .is_small = false, .is_immortal = false },
+        Flags {
+            .is_small = false,
+            .is_immortal = false,
+            .is_slice = false,
+            .is_embedded = false,
+            .is_mapped = false,
+        },
         Data { .char8_ptr = buffer },
         0U
     );
 }
 
+String* String::allocate_copy_utf8(const char8_t* bytes, size_t length)
+{
+    if (length < MAX_SHORT_STRING_LEN) {
+        Data data;
+        memcpy(data.short_string, bytes, length * sizeof(char8_t));
+        data.short_string[length] = u8'\0';
+        return new String(
+            Flags {
+                .is_small = true,
+                .is_immortal = false,
+                .is_slice = false,
+                .is_embedded = false,
+                .is_mapped = false,
+            },
+            data,
+            length
+        );
+    }
+
+    String* result = allocate_runtime_utf8(length);
+    memcpy(result->m_data.char8_ptr, bytes, length * sizeof(char8_t));
+    result->m_length = length;
+    return result;
+}
+
 RcPointer<String> String::add(const String* other) const
 {
     size_t length = m_length + other->m_length;
@@ -52,7 +98,17 @@ RcPointer<String> String::add(const String* other) const
             other->m_length * sizeof(char8_t)
         );
         data.short_string[length] = u8'\0';
-        return new String(Flags { .is_small = true, .is_immortal = false }, data, length);
+        return new String(
+            Flags {
+                .is_small = true,
+                .is_immortal = false,
+                .is_slice = false,
+                .is_embedded = false,
+                .is_mapped = false,
+            },
+            data,
+            length
+        );
     }
 
     char8_t* buffer = (char8_t*)calloc(length + 1U, sizeof(char8_t));
@@ -67,7 +123,13 @@ RcPointer<String> String::add(const String* other) const
     memcpy(buffer, buffer_ptr(), m_length);
     memcpy(buffer + m_length, other->buffer_ptr(), other->m_length);
     return new String(
-        Flags { .is_small = false, .is_immortal = false },
+        Flags {
+            .is_small = false,
+            .is_immortal = false,
+            .is_slice = false,
+            .is_embedded = false,
+            .is_mapped = false,
+        },
         Data { .char8_ptr = buffer },
         length
     );
@@ -81,14 +143,7 @@ Char String::_indexget(Int index) const noexcept
     return buffer_ptr()[index];
 }
 
-void String::print() const
-{
-    errno = 0;
-    int result = puts(reinterpret_cast<const char*>(buffer_ptr()));
-    if (result == EOF) {
-        throw std::system_error(errno, std::generic_category());
-    }
-}
+void String::print() const { falafel_internal::write_line(buffer_ptr(), m_length); }
 
 Bool String::is_equal(const String* other) const noexcept
 {
@@ -102,3 +157,306 @@ Bool String::is_equal(const String* other) const noexcept
 
     return memcmp(buffer_ptr(), other->buffer_ptr(), m_length * sizeof(char8_t)) == 0;
 }
+
+// The search helpers below scan a whole vector register per iteration. SSE2 is part of the x86-64
+// baseline, so it is always available there; AVX2 is used instead when the library is built with
+// -mavx2 (or -march=native on a machine that has it).
+
+#if defined(__AVX2__)
+using ByteVector = __m256i;
+constexpr size_t VECTOR_SIZE = 32U;
+
+static inline ByteVector splat(char8_t c) noexcept
+{
+    return _mm256_set1_epi8(static_cast<char>(c));
+}
+
+static inline ByteVector load(const char8_t* p) noexcept
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+static inline uint32_t match_mask(ByteVector a, ByteVector b) noexcept
+{
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+}
+#elif defined(__SSE2__)
+using ByteVector = __m128i;
+constexpr size_t VECTOR_SIZE = 16U;
+
+static inline ByteVector splat(char8_t c) noexcept { return _mm_set1_epi8(static_cast<char>(c)); }
+
+static inline ByteVector load(const char8_t* p) noexcept
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static inline uint32_t match_mask(ByteVector a, ByteVector b) noexcept
+{
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+}
+#endif
+
+static const char8_t* find_byte(const char8_t* haystack, size_t length, char8_t needle) noexcept
+{
+    // glibc's memchr is already vectorized and picks the widest instruction set at load time.
+    return static_cast<const char8_t*>(memchr(haystack, needle, length));
+}
+
+static size_t count_byte(const char8_t* haystack, size_t length, char8_t needle) noexcept
+{
+    size_t result = 0U;
+    size_t i = 0U;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    ByteVector pattern = splat(needle);
+    for (; i + VECTOR_SIZE <= length; i += VECTOR_SIZE) {
+        result += static_cast<size_t>(std::popcount(match_mask(load(haystack + i), pattern)));
+    }
+#endif
+
+    for (; i < length; ++i) {
+        result += haystack[i] == needle;
+    }
+
+    return result;
+}
+
+/**
+ * Substring search. Candidate positions are those where both the first and the last byte of the
+ * needle match, which filters out nearly everything in a single vector comparison; only the
+ * survivors are checked with memcmp.
+ */
+static const char8_t* find_bytes(
+    const char8_t* haystack, size_t length, const char8_t* needle, size_t needle_length
+) noexcept
+{
+    if (needle_length == 0U) {
+        return haystack;
+    }
+    if (needle_length > length) {
+        return nullptr;
+    }
+    if (needle_length == 1U) {
+        return find_byte(haystack, length, needle[0]);
+    }
+
+    size_t last_start = length - needle_length;
+    size_t i = 0U;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    ByteVector first = splat(needle[0]);
+    ByteVector last = splat(needle[needle_length - 1U]);
+
+    for (; i + VECTOR_SIZE <= last_start + 1U; i += VECTOR_SIZE) {
+        ByteVector block_first = load(haystack + i);
+        ByteVector block_last = load(haystack + i + needle_length - 1U);
+        uint32_t mask = match_mask(block_first, first) & match_mask(block_last, last);
+
+        while (mask != 0U) {
+            size_t offset = static_cast<size_t>(std::countr_zero(mask));
+            if (memcmp(haystack + i + offset + 1U, needle + 1U, needle_length - 2U) == 0) {
+                return haystack + i + offset;
+            }
+            mask &= mask - 1U;
+        }
+    }
+#endif
+
+    for (; i <= last_start; ++i) {
+        if (haystack[i] == needle[0]
+            && memcmp(haystack + i + 1U, needle + 1U, needle_length - 1U) == 0) {
+            return haystack + i;
+        }
+    }
+
+    return nullptr;
+}
+
+Int String::find(const String* needle) const noexcept
+{
+    const char8_t* haystack = buffer_ptr();
+    const char8_t* match = find_bytes(haystack, m_length, needle->buffer_ptr(), needle->m_length);
+    return match == nullptr ? -1 : static_cast<Int>(match - haystack);
+}
+
+Int String::find(Char needle) const noexcept
+{
+    const char8_t* haystack = buffer_ptr();
+    const char8_t* match = find_byte(haystack, m_length, needle);
+    return match == nullptr ? -1 : static_cast<Int>(match - haystack);
+}
+
+Bool String::starts_with(const String* prefix) const noexcept
+{
+    return prefix->m_length <= m_length
+        && memcmp(buffer_ptr(), prefix->buffer_ptr(), prefix->m_length * sizeof(char8_t)) == 0;
+}
+
+Bool String::ends_with(const String* suffix) const noexcept
+{
+    return suffix->m_length <= m_length
+        && memcmp(
+               buffer_ptr() + (m_length - suffix->m_length),
+               suffix->buffer_ptr(),
+               suffix->m_length * sizeof(char8_t)
+           )
+        == 0;
+}
+
+Int String::count(const String* needle) const noexcept
+{
+    if (needle->m_length == 0U) {
+        return static_cast<Int>(m_length + 1U);
+    }
+    if (needle->m_length == 1U) {
+        return count(needle->buffer_ptr()[0]);
+    }
+
+    const char8_t* haystack = buffer_ptr();
+    const char8_t* end = haystack + m_length;
+    Int result = 0;
+
+    while (const char8_t* match = find_bytes(
+               haystack,
+               static_cast<size_t>(end - haystack),
+               needle->buffer_ptr(),
+               needle->m_length
+           )) {
+        ++result;
+        haystack = match + needle->m_length;
+    }
+
+    return result;
+}
+
+Int String::count(Char needle) const noexcept
+{
+    return static_cast<Int>(count_byte(buffer_ptr(), m_length, needle));
+}
+
+Array<RcPointer<String>> String::split(const String* separator) const
+{
+    const char8_t* start = buffer_ptr();
+    const char8_t* end = start + m_length;
+
+    if (separator->m_length == 0U) {
+        Array<RcPointer<String>> result(m_length);
+        for (const char8_t* p = start; p != end; ++p) {
+            result.push(slice(static_cast<size_t>(p - buffer_ptr()), 1U));
+        }
+        return result;
+    }
+
+    Array<RcPointer<String>> result(static_cast<size_t>(count(separator)) + 1U);
+
+    while (const char8_t* match = find_bytes(
+               start,
+               static_cast<size_t>(end - start),
+               separator->buffer_ptr(),
+               separator->m_length
+           )) {
+        result.push(slice(
+            static_cast<size_t>(start - buffer_ptr()),
+            static_cast<size_t>(match - start)
+        ));
+        start = match + separator->m_length;
+    }
+    result.push(slice(static_cast<size_t>(start - buffer_ptr()), static_cast<size_t>(end - start)));
+
+    return result;
+}
+
+// from_chars accepts exactly the formats documented on these methods, never skips whitespace, and
+// doesn't depend on the locale. Anything left unparsed makes the whole string invalid.
+template<typename T>
+static Optional<T> parse_whole(const char8_t* bytes, size_t length) noexcept
+{
+    const char* first = reinterpret_cast<const char*>(bytes);
+    const char* last = first + length;
+
+    T result;
+    auto [end, error] = std::from_chars(first, last, result);
+    if (error != std::errc {} || end != last) {
+        return nullptr;
+    }
+    return result;
+}
+
+Optional<Int> String::parse_int() const noexcept
+{
+    return parse_whole<Int>(buffer_ptr(), m_length);
+}
+
+Optional<Double> String::parse_double() const noexcept
+{
+    return parse_whole<Double>(buffer_ptr(), m_length);
+}
+
+// A slice keeps its whole parent alive, so a short slice of a huge string could pin far more memory
+// than it exposes. Slices are only shared when they cover at least 1/MAX_SLICE_WASTE_FACTOR of the
+// parent, or the parent is under MIN_COMPACTED_PARENT_LEN bytes; otherwise the bytes are copied.
+// So a slice of a freeable parent pins at most MAX_SLICE_WASTE_FACTOR times its own size, or the
+// whole parent when that is under MIN_COMPACTED_PARENT_LEN bytes, and copying never costs more than
+// 1/MAX_SLICE_WASTE_FACTOR of the parent. Immortal parents are never freed, so sharing them pins
+// nothing, and mapped files only pin clean pages that the kernel can drop at any time, so both are
+// always sliced whatever their size.
+static constexpr size_t MAX_SLICE_WASTE_FACTOR = 16U;
+static constexpr size_t MIN_COMPACTED_PARENT_LEN = 4096U;
+
+RcPointer<String> String::slice(size_t offset, size_t length) const
+{
+    assert(offset + length <= m_length);
+
+    if (length == m_length) {
+        String* self = const_cast<String*>(this);
+        self->retain();
+        return self;
+    }
+
+    const char8_t* start = buffer_ptr() + offset;
+
+    if (length < MAX_SHORT_STRING_LEN) {
+        return allocate_copy_utf8(start, length);
+    }
+
+    // Always point at the buffer's owner, so that slices of slices don't form chains.
+    String* parent = m_flags.is_slice ? m_data.slice.parent : const_cast<String*>(this);
+
+    if (!parent->m_flags.is_immortal && !parent->m_flags.is_mapped
+        && parent->m_length >= MIN_COMPACTED_PARENT_LEN
+        && length * MAX_SLICE_WASTE_FACTOR < parent->m_length) {
+        return allocate_copy_utf8(start, length);
+    }
+
+    parent->retain();
+    return new String(
+        Flags {
+            .is_small = false,
+            .is_immortal = false,
+            .is_slice = true,
+            .is_embedded = false,
+            .is_mapped = false,
+        },
+        Data { .slice = { .start = start, .parent = parent } },
+        length
+    );
+}
+
+RcPointer<String> String::substring(Int start, Int end) const
+{
+    if (start < 0 || end < start || end > m_length) [[unlikely]] {
+        panic("Substring range out of bounds");
+    }
+    return slice(static_cast<size_t>(start), static_cast<size_t>(end - start));
+}
+
+Int String::compare(const String* other) const noexcept
+{
+    size_t common_length = min(m_length, other->m_length);
+    int result = memcmp(buffer_ptr(), other->buffer_ptr(), common_length * sizeof(char8_t));
+    if (result != 0) {
+        return result;
+    }
+    return m_length < other->m_length ? -1 : m_length > other->m_length ? 1 : 0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "array.hh"
+#include "optional.hh"
 #include "refcount.hh"
 #include "typedefs.hh"
 #include <cassert>
@@ -7,6 +9,8 @@
 #include <functional>
 
 class String final : public Object {
+    friend struct HeapProfiler;
+    friend struct LineIterator;
     friend struct StringBuilder;
     friend struct TypeInfo;
 
@@ -14,10 +18,17 @@ private:
     struct Flags {
         bool is_small : 1;
         bool is_immortal : 1;
+        bool is_slice : 1;
+        // The buffer is part of the same allocation as the String, directly after it.
+        bool is_embedded : 1;
+        // The buffer is a read-only memory mapping of a file, to be unmapped on destruction.
+        bool is_mapped : 1;
 
         inline bool operator==(const Flags& other) const noexcept
         {
-            return is_small == other.is_small && is_immortal == other.is_immortal;
+            return is_small == other.is_small && is_immortal == other.is_immortal
+                && is_slice == other.is_slice && is_embedded == other.is_embedded
+                && is_mapped == other.is_mapped;
         }
     };
 
@@ -30,7 +41,13 @@ public:
         size_t length = strlen(reinterpret_cast<const char*>(literal));
 
         return new String(
-            Flags { .is_small = false, .is_immortal = true },
+            Flags {
+                .is_small = false,
+                .is_immortal = true,
+                .is_slice = false,
+                .is_embedded = false,
+                .is_mapped = false,
+            },
             Data { .char8_literal = literal },
             length,
             ImmortalMarker {}
@@ -47,15 +64,47 @@ public:
         memcpy(data.short_string, literal, (length + 1U) * sizeof(char8_t));
 
         return new String(
-            Flags { .is_small = true, .is_immortal = true },
+            Flags {
+                .is_small = true,
+                .is_immortal = true,
+                .is_slice = false,
+                .is_embedded = false,
+                .is_mapped = false,
+            },
             data,
             length,
             ImmortalMarker {}
         );
     }
 
+    // Constant-initializes an immortal string from a literal, whose length is known from the array
+    // bound. Intended for objects held in an `ImmortalStorage` so that no code runs at startup.
+    template<size_t N>
+    constexpr String(const char8_t (&literal)[N]) noexcept :
+        Object(ImmortalMarker {}),
+        m_data { .char8_literal = literal },
+        m_flags {
+            .is_small = false,
+            .is_immortal = true,
+            .is_slice = false,
+            .is_embedded = false,
+            .is_mapped = false,
+        },
+        m_length(N - 1U)
+    {
+    }
+
     static String* const empty;
 
+    // Reads the next line from stdin, without its line terminator. Returns null at end of input.
+    // Defined in input.cpp.
+    static Optional<RcPointer<String>> read_line();
+
+    // Reads a whole file. Large regular files are memory-mapped rather than copied, so their pages
+    // are only loaded as they are accessed. Returns null if the file can't be read.
+    // Defined in input.cpp.
+    static Optional<RcPointer<String>> read_file(const String* path);
+
     RcPointer<String> add(const String* other) const;
 
     Bool is_equal(const String* other) const noexcept __attribute__((pure));
@@ -64,6 +113,48 @@ public:
 
     Char _indexget(Int index) const noexcept __attribute__((pure));
 
+    // Returns the byte offset of the first occurrence of `needle`, or -1 if there is none.
+    Int find(const String* needle) const noexcept __attribute__((pure));
+    Int find(Char needle) const noexcept __attribute__((pure));
+
+    inline Bool contains(const String* needle) const noexcept { return find(needle) >= 0; }
+    inline Bool contains(Char needle) const noexcept { return find(needle) >= 0; }
+
+    Bool starts_with(const String* prefix) const noexcept __attribute__((pure));
+    Bool ends_with(const String* suffix) const noexcept __attribute__((pure));
+
+    // Counts non-overlapping occurrences of `needle`.
+    Int count(const String* needle) const noexcept __attribute__((pure));
+    Int count(Char needle) const noexcept __attribute__((pure));
+
+    Array<RcPointer<String>> split(const String* separator) const;
+
+    // Parses the whole string as a decimal integer with an optional leading minus sign. Returns
+    // null if the string is not such a number or does not fit in an Int.
+    Optional<Int> parse_int() const noexcept __attribute__((pure));
+
+    // Parses the whole string as a decimal or scientific-notation number, "inf", or "nan", rounding
+    // to the nearest Double. Returns null if the string is not a number or is out of range.
+    Optional<Double> parse_double() const noexcept __attribute__((pure));
+
+    // Returns the bytes in [offset, offset + length). Long enough results share this string's
+    // buffer instead of copying it; see the comment on `slice` in string.cpp.
+    RcPointer<String> slice(size_t offset, size_t length) const;
+
+    // Bounds-checked version of `slice` taking a half-open range, as exposed to falafel code.
+    RcPointer<String> substring(Int start, Int end) const;
+
+    // Bytewise lexicographic comparison. Returns a negative number, zero, or a positive number.
+    Int compare(const String* other) const noexcept __attribute__((pure));
+
+    inline Bool is_less(const String* other) const noexcept { return compare(other) < 0; }
+    inline Bool is_less_equal(const String* other) const noexcept { return compare(other) <= 0; }
+    inline Bool is_greater(const String* other) const noexcept { return compare(other) > 0; }
+    inline Bool is_greater_equal(const String* other) const noexcept
+    {
+        return compare(other) >= 0;
+    }
+
     constexpr size_t length() const noexcept { return m_length; }
 
     void print() const;
@@ -71,18 +162,42 @@ public:
     ~String() noexcept;
 
     constexpr Int f_lengthib() const noexcept { return static_cast<Int>(length()); }
+    inline Int f_findif(const String* needle) const noexcept { return find(needle); }
+    inline Int f_findie(Char needle) const noexcept { return find(needle); }
+    inline Bool f_containsbf(const String* needle) const noexcept { return contains(needle); }
+    inline Bool f_containsbe(Char needle) const noexcept { return contains(needle); }
+    inline Bool f_startsWithbf(const String* prefix) const noexcept { return starts_with(prefix); }
+    inline Bool f_endsWithbf(const String* suffix) const noexcept { return ends_with(suffix); }
+    inline Int f_countif(const String* needle) const noexcept { return count(needle); }
+    inline Int f_countie(Char needle) const noexcept { return count(needle); }
+    inline Array<RcPointer<String>> f_splitasf(const String* separator) const
+    {
+        return split(separator);
+    }
+    inline RcPointer<String> f_substringsq(Int start, Int end) const
+    {
+        return substring(start, end);
+    }
+    inline Int f_compareif(const String* other) const noexcept { return compare(other); }
 
     inline virtual RcPointer<String> f_toStringsb() override { return this; }
 
+    static constexpr falafel_internal::FixedString type_name { u8"String" };
+    static constexpr falafel_internal::ClassIdRange class_ids {
+        falafel_internal::ClassId::string, falafel_internal::ClassId::string
+    };
+
     static const TypeInfo& get_type_info_static() noexcept;
     virtual const TypeInfo& get_type_info_dynamic() const noexcept override;
 
 private:
     static String* allocate_runtime_utf8(size_t length);
+    static String* allocate_copy_utf8(const char8_t* bytes, size_t length);
 
     constexpr const char8_t* buffer_ptr() const noexcept
     {
         return m_flags.is_small   ? m_data.short_string
+            : m_flags.is_slice    ? m_data.slice.start
             : m_flags.is_immortal ? m_data.char8_literal
                                   : m_data.char8_ptr;
     }
@@ -91,6 +206,10 @@ private:
         char8_t* char8_ptr;
         const char8_t* char8_literal;
         char8_t short_string[MAX_SHORT_STRING_LEN];
+        struct __attribute__((packed)) {
+            const char8_t* start;
+            String* parent;
+        } slice;
     };
 
     constexpr String(Flags flags, Data data, size_t length) noexcept :
@@ -107,4 +226,19 @@ private:
     size_t m_length;
 };
 
+namespace falafel_internal {
+template<typename T>
+struct StaticTypeInfo {
+    static constexpr auto name = type_name<T>;
+    static constinit inline ImmortalStorage<String> name_string { name.chars };
+    static constexpr TypeInfo info {
+        .name = &name_string.value,
+        .name_hash = pjw_hash(name),
+        .class_ids = class_ids<T>,
+    };
+};
+}
+
 inline Void f_printvf(String* s) { s->print(); }
+inline Optional<Int> f_parseIntoif(String* s) { return s->parse_int(); }
+inline Optional<Double> f_parseDoubleodf(String* s) { return s->parse_double(); }
@@ -1,115 +1,205 @@
 #include "stringbuilder.hh"
-#include <cinttypes>
+#include "max.hh"
+#include <array>
+#include <cassert>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+static constinit ImmortalStorage<String> null_str_storage(u8"null");
+static constinit ImmortalStorage<String> infinity_str_storage(u8"Infinity");
+static constinit ImmortalStorage<String> minus_infinity_str_storage(u8"-Infinity");
+static constinit ImmortalStorage<String> nan_str_storage(u8"NaN");
+static constinit ImmortalStorage<String> true_str_storage(u8"true");
+static constinit ImmortalStorage<String> false_str_storage(u8"false");
+
+String* const StringBuilder::null_str = &null_str_storage.value;
+
+static String* const infinity_str = &infinity_str_storage.value;
+static String* const minus_infinity_str = &minus_infinity_str_storage.value;
+static String* const nan_str = &nan_str_storage.value;
+static String* const true_str = &true_str_storage.value;
+static String* const false_str = &false_str_storage.value;
+
+StringBuilder::StringBuilder(size_t capacity) :
+    m_block(nullptr), m_bytes(m_inline), m_length(0U), m_capacity(INLINE_CAPACITY)
+{
+    reserve(capacity);
+}
 
-String* const StringBuilder::empty_brackets = String::allocate_small_utf8(u8"[]");
-String* const StringBuilder::open_bracket = String::allocate_small_utf8(u8"[");
-String* const StringBuilder::close_bracket = String::allocate_small_utf8(u8"]");
-String* const StringBuilder::comma_space = String::allocate_small_utf8(u8", ");
-String* const StringBuilder::null_str = String::allocate_small_utf8(u8"null");
+void StringBuilder::grow(size_t additional)
+{
+    size_t capacity = max(m_capacity * 2U, m_length + additional);
+    size_t block_size = HEADER_SIZE + (capacity + 1U) * sizeof(char8_t);
+
+    void* block = realloc(m_block, block_size);
+    if (block == nullptr) [[unlikely]] {
+        Object::collect_cycles();
+        block = realloc(m_block, block_size);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
 
-static String* const infinity_str = String::allocate_immortal_utf8(u8"Infinity");
-static String* const minus_infinity_str = String::allocate_immortal_utf8(u8"-Infinity");
-static String* const nan_str = String::allocate_small_utf8(u8"NaN");
-static String* const true_str = String::allocate_small_utf8(u8"true");
-static String* const false_str = String::allocate_small_utf8(u8"false");
+    char8_t* bytes = static_cast<char8_t*>(block) + HEADER_SIZE;
+    if (m_block == nullptr) {
+        memcpy(bytes, m_inline, m_length * sizeof(char8_t));
+    }
 
-void StringBuilder::add_runtime_allocated_piece(char* piece, size_t length)
+    m_block = block;
+    m_bytes = bytes;
+    m_capacity = capacity;
+}
+
+void StringBuilder::reset() noexcept
 {
-    String* str = String::allocate_runtime_utf8(length);
-    memcpy(str->m_data.char8_ptr, piece, length);
-    str->m_length = length;
-    m_pieces.push(str);
+    m_block = nullptr;
+    m_bytes = m_inline;
+    m_length = 0U;
+    m_capacity = INLINE_CAPACITY;
 }
 
-void StringBuilder::add_piece(Int piece)
+void StringBuilder::add_bytes(const char8_t* bytes, size_t length)
 {
-    String* str = String::allocate_runtime_utf8(20U);
-    str->m_length = static_cast<size_t>(
-        snprintf(reinterpret_cast<char*>(str->m_data.char8_ptr), 21U, "%" PRIdFAST32, piece)
-    );
-    m_pieces.push(str);
+    reserve(length);
+    memcpy(m_bytes + m_length, bytes, length * sizeof(char8_t));
+    m_length += length;
+}
+
+// Digits of 0 through 99, two at a time.
+static constexpr auto DIGIT_PAIRS = [] {
+    std::array<char8_t, 200U> result {};
+    for (size_t i = 0U; i < 100U; ++i) {
+        result[2U * i] = static_cast<char8_t>(u8'0' + i / 10U);
+        result[2U * i + 1U] = static_cast<char8_t>(u8'0' + i % 10U);
+    }
+    return result;
+}();
+
+void StringBuilder::add_integer(uint64_t magnitude, bool negative)
+{
+    // Digits are produced two at a time from the least significant end, into a scratch buffer big
+    // enough for any 64-bit value and its sign.
+    char8_t digits[20U];
+    char8_t* start = digits + sizeof digits;
+
+    while (magnitude >= 100U) {
+        size_t pair = static_cast<size_t>(magnitude % 100U) * 2U;
+        magnitude /= 100U;
+        *--start = DIGIT_PAIRS[pair + 1U];
+        *--start = DIGIT_PAIRS[pair];
+    }
+    if (magnitude >= 10U) {
+        size_t pair = static_cast<size_t>(magnitude) * 2U;
+        *--start = DIGIT_PAIRS[pair + 1U];
+        *--start = DIGIT_PAIRS[pair];
+    } else {
+        *--start = static_cast<char8_t>(u8'0' + magnitude);
+    }
+    if (negative) {
+        *--start = u8'-';
+    }
+
+    add_bytes(start, static_cast<size_t>(digits + sizeof digits - start));
+}
+
+// std::to_chars without a precision produces the shortest representation that reads back as the
+// same value, and unlike snprintf it ignores the locale.
+template<typename T>
+static size_t format_shortest(char8_t* out, size_t capacity, T value) noexcept
+{
+    char* first = reinterpret_cast<char*>(out);
+    auto [last, error] = std::to_chars(first, first + capacity, value);
+    assert(error == std::errc {});
+    return static_cast<size_t>(last - first);
 }
 
 void StringBuilder::add_piece(Float piece)
 {
     if (std::isfinite(piece)) [[likely]] {
-        String* str = String::allocate_runtime_utf8(16U);
-        str->m_length = static_cast<size_t>(
-            snprintf(reinterpret_cast<char*>(str->m_data.char8_ptr), 17U, "%.9g", (double)piece)
-        );
-        m_pieces.push(str);
+        // Longest case: -1.17549435e-38
+        reserve(15U);
+        m_length += format_shortest(m_bytes + m_length, 15U, piece);
     } else if (std::isnan(piece)) {
-        m_pieces.push(nan_str);
+        add_piece(nan_str);
     } else if (piece > 0.0f) {
-        m_pieces.push(infinity_str);
+        add_piece(infinity_str);
     } else {
-        m_pieces.push(minus_infinity_str);
+        add_piece(minus_infinity_str);
     }
 }
 
 void StringBuilder::add_piece(Double piece)
 {
     if (std::isfinite(piece)) [[likely]] {
-        String* str = String::allocate_runtime_utf8(24U);
-        str->m_length = static_cast<size_t>(
-            snprintf(reinterpret_cast<char*>(str->m_data.char8_ptr), 25U, "%.17g", piece)
-        );
-        m_pieces.push(str);
+        // Longest case: -2.2250738585072014e-308
+        reserve(24U);
+        m_length += format_shortest(m_bytes + m_length, 24U, piece);
     } else if (std::isnan(piece)) {
-        m_pieces.push(nan_str);
+        add_piece(nan_str);
     } else if (piece > 0.0) {
-        m_pieces.push(infinity_str);
+        add_piece(infinity_str);
     } else {
-        m_pieces.push(minus_infinity_str);
+        add_piece(minus_infinity_str);
     }
 }
 
-void StringBuilder::add_piece(Bool piece) { m_pieces.push(piece ? true_str : false_str); }
-
-void StringBuilder::add_piece(Char piece)
-{
-    String* str = new String(
-        String::Flags { .is_small = true, .is_immortal = false },
-        String::Data { .short_string = { piece, u8'\0' } },
-        1U
-    );
-    m_pieces.push(str);
-}
+void StringBuilder::add_piece(Bool piece) { add_piece(piece ? true_str : false_str); }
 
 RcPointer<String> StringBuilder::build()
 {
-    if (m_pieces.length() == 0U) [[unlikely]] {
+    if (m_length == 0U) [[unlikely]] {
         return String::empty;
     }
-    if (m_pieces.length() == 1U) {
-        RcPointer<String> result = m_pieces._indexget(0);
-        m_pieces.clear();
-        return result;
-    }
 
-    size_t length = 0U;
+    if (m_length < String::MAX_SHORT_STRING_LEN) {
+        String::Data data;
+        memcpy(data.short_string, m_bytes, m_length * sizeof(char8_t));
+        data.short_string[m_length] = u8'\0';
+
+        String* result = new String(
+            String::Flags {
+                .is_small = true,
+                .is_immortal = false,
+                .is_slice = false,
+                .is_embedded = false,
+                .is_mapped = false,
+            },
+            data,
+            m_length
+        );
 
-    for (size_t i = 0U; i < m_pieces.length(); ++i) {
-        length += m_pieces._indexget(static_cast<Int>(i))->m_length;
+        free(m_block);
+        reset();
+        return result;
     }
 
-    String* result = String::allocate_runtime_utf8(length);
-
-    size_t offset = 0U;
-    for (size_t i = 0U; i < m_pieces.length(); ++i) {
-        auto& piece = m_pieces._indexget(static_cast<Int>(i));
-        const char8_t* piece_buffer = piece->m_flags.is_small ? piece->m_data.short_string
-            : piece->m_flags.is_immortal                      ? piece->m_data.char8_literal
-                                                              : piece->m_data.char8_ptr;
-
-        memcpy(result->m_data.char8_ptr + offset, piece_buffer, piece->m_length);
-        offset += piece->m_length;
+    // Give back the slack left by doubling, if there is a lot of it. Shrinking rarely moves the
+    // block, and keeping the larger block is fine if it fails.
+    if (m_capacity / 2U > m_length) {
+        void* block = realloc(m_block, HEADER_SIZE + (m_length + 1U) * sizeof(char8_t));
+        if (block != nullptr) {
+            m_block = block;
+            m_bytes = static_cast<char8_t*>(block) + HEADER_SIZE;
+        }
     }
 
-    result->m_length = length;
-
-    m_pieces.clear();
+    m_bytes[m_length] = u8'\0';
+
+    String* result = new (m_block) String(
+        String::Flags {
+            .is_small = false,
+            .is_immortal = false,
+            .is_slice = false,
+            .is_embedded = true,
+            .is_mapped = false,
+        },
+        String::Data { .char8_ptr = m_bytes },
+        m_length
+    );
 
+    reset();
     return result;
 }
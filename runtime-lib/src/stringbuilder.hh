@@ -5,51 +5,73 @@
 #include "panic.hh"
 #include "string.hh"
 #include "typedefs.hh"
+#include <concepts>
 #include <cstddef>
-#include <functional>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
 
+// Pieces are appended straight into one growing buffer. Short results are collected in an inline
+// buffer and become small strings; longer ones are written into a heap block that leaves room for
+// a String header in front, so `build()` turns the block into the result without copying.
 struct StringBuilder final {
 private:
-    static String* const empty_brackets;
-    static String* const open_bracket;
-    static String* const close_bracket;
-    static String* const comma_space;
     static String* const null_str;
 
 public:
-    inline StringBuilder(size_t count) : m_pieces(count) { }
+    // `capacity` is an estimate of the built string's length in bytes. Going over it is allowed,
+    // but costs a reallocation.
+    explicit StringBuilder(size_t capacity);
 
-    inline void add_piece(String* piece) { m_pieces.push(piece); }
-    inline void add_piece(const RcPointer<String>& piece) { m_pieces.push(piece); }
-    inline void add_piece(RcPointer<String>&& piece) { m_pieces.push(std::move(piece)); }
+    StringBuilder(const StringBuilder&) = delete;
+    StringBuilder& operator=(const StringBuilder&) = delete;
 
-    void add_runtime_allocated_piece(char* piece, size_t length);
+    inline ~StringBuilder() noexcept { free(m_block); }
+
+    void add_bytes(const char8_t* bytes, size_t length);
+
+    inline void add_piece(const String* piece) { add_bytes(piece->buffer_ptr(), piece->length()); }
+    inline void add_piece(const RcPointer<String>& piece)
+    {
+        add_piece(static_cast<const String*>(piece));
+    }
+
+    // Covers Int and the sized integers, some of which are the same C++ type as Int.
+    template<std::integral T>
+        requires(!std::is_same_v<T, Bool> && !std::is_same_v<T, Char>)
+    inline void add_piece(T piece)
+    {
+        uint64_t magnitude = static_cast<uint64_t>(piece);
+        if constexpr (std::is_signed_v<T>) {
+            if (piece < 0) {
+                add_integer(0U - magnitude, true);
+                return;
+            }
+        }
+        add_integer(magnitude, false);
+    }
 
-    void add_piece(Int piece);
     void add_piece(Float piece);
     void add_piece(Double piece);
     void add_piece(Bool piece);
-    void add_piece(Char piece);
 
-    template<typename T>
-    void add_piece(Array<T> piece)
+    inline void add_piece(Char piece)
     {
-        if (piece.length() == 0U) {
-            m_pieces.push(empty_brackets);
-            return;
-        }
+        reserve(1U);
+        m_bytes[m_length++] = piece;
+    }
 
-        StringBuilder inner(static_cast<size_t>(piece.length()) * 2U + 1U);
-        inner.add_piece(open_bracket);
+    template<typename T>
+    void add_piece(const Array<T>& piece)
+    {
+        add_piece(u8'[');
         for (size_t i = 0U; i < piece.length(); ++i) {
             if (i != 0U) {
-                inner.add_piece(comma_space);
+                add_bytes(u8", ", 2U);
             }
-            inner.add_piece(piece._indexget(i));
+            add_piece(piece._indexget(static_cast<Int>(i)));
         }
-        inner.add_piece(close_bracket);
-
-        m_pieces.push(inner.build());
+        add_piece(u8']');
     }
 
     template<typename T>
@@ -73,18 +95,36 @@ public:
     }
 
     template<typename T>
-    void add_piece(RcPointer<T> piece)
+    void add_piece(const RcPointer<T>& piece)
     {
-        m_pieces.push(piece->f_toStringsb());
+        add_piece(piece->f_toStringsb());
     }
 
+    // Returns the built string and leaves the builder empty.
     RcPointer<String> build();
 
-    inline void visit_children(std::function<void(Object*)> visitor)
+private:
+    static constexpr size_t HEADER_SIZE = sizeof(String);
+    static constexpr size_t INLINE_CAPACITY = String::MAX_SHORT_STRING_LEN - 1U;
+
+    // Makes room for `additional` more bytes, not counting the NUL terminator.
+    inline void reserve(size_t additional)
     {
-        m_pieces.visit_children(visitor);
+        if (m_capacity - m_length < additional) [[unlikely]] {
+            grow(additional);
+        }
     }
 
-private:
-    Array<RcPointer<String>> m_pieces;
+    void grow(size_t additional);
+    void add_integer(uint64_t magnitude, bool negative);
+    void reset() noexcept;
+
+    // Heap block holding space for a String followed by the bytes, or null while the bytes still
+    // fit in `m_inline`.
+    void* m_block;
+    char8_t* m_bytes;
+    size_t m_length;
+    // Not counting the NUL terminator.
+    size_t m_capacity;
+    char8_t m_inline[INLINE_CAPACITY + 1U];
 };
@@ -8,3 +8,14 @@ using Double = double;
 using Float = float;
 using Void = void;
 using Char = char8_t;
+
+// Fixed-width integers, for data where Int would waste space. One of these is usually the same C++
+// type as Int.
+using Int8 = int8_t;
+using Int16 = int16_t;
+using Int32 = int32_t;
+using Int64 = int64_t;
+using UInt8 = uint8_t;
+using UInt16 = uint16_t;
+using UInt32 = uint32_t;
+using UInt64 = uint64_t;
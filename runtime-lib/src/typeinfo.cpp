@@ -3,31 +3,31 @@
 
 // TODO: include information besides name?
 
-uint64_t TypeInfo::hash() const noexcept
-{
-    // PJW hash
-    const char8_t* s = name->buffer_ptr();
-    uint64_t result = 0ULL;
-
-    for (size_t i = 0U; i < name->length(); ++i) {
-        result = (result << 8U) + s[i];
-        uint64_t high = result & 0xFF00'0000'0000'0000ULL;
-        if (high != 0ULL) {
-            result ^= high >> 48U;
-            result &= ~high;
-        }
-    }
+uint64_t TypeInfo::hash() const noexcept { return name_hash; }
 
-    return result;
+bool TypeInfo::is_equal(const TypeInfo& other) const noexcept
+{
+    return name == other.name || (name_hash == other.name_hash && name->is_equal(other.name));
 }
 
-bool TypeInfo::is_equal(const TypeInfo& other) const noexcept { return name->is_equal(other.name); }
-
 namespace falafel_internal {
-const TypeInfo int_info = TypeInfo { .name = String::allocate_small_utf8(u8"Int") };
-const TypeInfo double_info = TypeInfo { .name = String::allocate_small_utf8(u8"Double") };
-const TypeInfo float_info = TypeInfo { .name = String::allocate_small_utf8(u8"Float") };
-const TypeInfo bool_info = TypeInfo { .name = String::allocate_small_utf8(u8"Bool") };
-const TypeInfo void_info = TypeInfo { .name = String::allocate_small_utf8(u8"Void") };
-const TypeInfo char_info = TypeInfo { .name = String::allocate_small_utf8(u8"Char") };
+static constinit ImmortalStorage<String> int_name(u8"Int");
+static constinit ImmortalStorage<String> double_name(u8"Double");
+static constinit ImmortalStorage<String> float_name(u8"Float");
+static constinit ImmortalStorage<String> bool_name(u8"Bool");
+static constinit ImmortalStorage<String> void_name(u8"Void");
+static constinit ImmortalStorage<String> char_name(u8"Char");
+
+constinit const TypeInfo int_info
+    = TypeInfo { .name = &int_name.value, .name_hash = pjw_hash(type_name<Int>) };
+constinit const TypeInfo double_info
+    = TypeInfo { .name = &double_name.value, .name_hash = pjw_hash(type_name<Double>) };
+constinit const TypeInfo float_info
+    = TypeInfo { .name = &float_name.value, .name_hash = pjw_hash(type_name<Float>) };
+constinit const TypeInfo bool_info
+    = TypeInfo { .name = &bool_name.value, .name_hash = pjw_hash(type_name<Bool>) };
+constinit const TypeInfo void_info
+    = TypeInfo { .name = &void_name.value, .name_hash = pjw_hash(type_name<Void>) };
+constinit const TypeInfo char_info
+    = TypeInfo { .name = &char_name.value, .name_hash = pjw_hash(type_name<Char>) };
 }
@@ -1,19 +1,167 @@
 #pragma once
 
 #include "typedefs.hh"
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 #include <typeindex>
 
 class String;
 
+namespace falafel_internal {
+// Every runtime class, numbered in preorder: a class comes right before all of its subclasses, so
+// a class and everything derived from it have consecutive IDs. Types that aren't classes are `none`.
+enum class ClassId : uint32_t {
+    none = 0U,
+    object,
+    string,
+};
+
+struct ClassIdRange {
+    ClassId first;
+    ClassId last;
+
+    // The range check as a single comparison, relying on unsigned wraparound below `first`.
+    constexpr bool contains(ClassId id) const noexcept
+    {
+        return static_cast<uint32_t>(id) - static_cast<uint32_t>(first)
+            <= static_cast<uint32_t>(last) - static_cast<uint32_t>(first);
+    }
+};
+}
+
 struct TypeInfo {
     String* name;
+    // Precomputed `hash()`, so that neither hashing nor comparing infos has to walk the name.
+    uint64_t name_hash;
+    // The type's own ID followed by the last ID among its subclasses.
+    falafel_internal::ClassIdRange class_ids {};
+
+    constexpr bool is_subclass_of(const TypeInfo& other) const noexcept
+    {
+        return class_ids.first != falafel_internal::ClassId::none
+            && other.class_ids.contains(class_ids.first);
+    }
 
     uint64_t hash() const noexcept;
     bool is_equal(const TypeInfo& other) const noexcept;
 };
 
 namespace falafel_internal {
+// A NUL-terminated string that can be built at compile time, used for the names of generic types.
+template<size_t N>
+struct FixedString {
+    char8_t chars[N] {};
+
+    constexpr FixedString() noexcept = default;
+
+    constexpr FixedString(const char8_t (&literal)[N]) noexcept
+    {
+        for (size_t i = 0U; i < N; ++i) {
+            chars[i] = literal[i];
+        }
+    }
+
+    constexpr size_t length() const noexcept { return N - 1U; }
+
+    template<size_t M>
+    constexpr FixedString<N + M - 1U> operator+(const FixedString<M>& other) const noexcept
+    {
+        FixedString<N + M - 1U> result;
+        for (size_t i = 0U; i < N - 1U; ++i) {
+            result.chars[i] = chars[i];
+        }
+        for (size_t i = 0U; i < M; ++i) {
+            result.chars[N - 1U + i] = other.chars[i];
+        }
+        return result;
+    }
+};
+
+// PJW hash
+constexpr uint64_t pjw_hash(const char8_t* s, size_t length) noexcept
+{
+    uint64_t result = 0ULL;
+
+    for (size_t i = 0U; i < length; ++i) {
+        result = (result << 8U) + s[i];
+        uint64_t high = result & 0xFF00'0000'0000'0000ULL;
+        if (high != 0ULL) {
+            result ^= high >> 48U;
+            result &= ~high;
+        }
+    }
+
+    return result;
+}
+
+template<size_t N>
+constexpr uint64_t pjw_hash(const FixedString<N>& s) noexcept
+{
+    return pjw_hash(s.chars, s.length());
+}
+
+// The name of a type, as a FixedString. Classes provide it as a static `type_name` member.
+template<typename T>
+constexpr auto type_name = T::type_name;
+
+template<typename T>
+constexpr auto integer_width_name() noexcept
+{
+    if constexpr (sizeof(T) == 1U) {
+        return FixedString(u8"8");
+    } else if constexpr (sizeof(T) == 2U) {
+        return FixedString(u8"16");
+    } else if constexpr (sizeof(T) == 4U) {
+        return FixedString(u8"32");
+    } else {
+        static_assert(sizeof(T) == 8U);
+        return FixedString(u8"64");
+    }
+}
+
+template<typename T>
+constexpr auto integer_name() noexcept
+{
+    if constexpr (std::is_signed_v<T>) {
+        return FixedString(u8"Int") + integer_width_name<T>();
+    } else {
+        return FixedString(u8"UInt") + integer_width_name<T>();
+    }
+}
+
+// Sized integers are named by signedness and width. Whichever one is the same C++ type as Int keeps
+// the name Int.
+template<std::integral T>
+constexpr auto type_name<T> = integer_name<T>();
+
+template<>
+constexpr auto type_name<Int> = FixedString(u8"Int");
+template<>
+constexpr auto type_name<Double> = FixedString(u8"Double");
+template<>
+constexpr auto type_name<Float> = FixedString(u8"Float");
+template<>
+constexpr auto type_name<Bool> = FixedString(u8"Bool");
+template<>
+constexpr auto type_name<Void> = FixedString(u8"Void");
+template<>
+constexpr auto type_name<Char> = FixedString(u8"Char");
+
+// The class IDs of a type. Classes provide them as a static `class_ids` member.
+template<typename T>
+constexpr ClassIdRange class_ids = { ClassId::none, ClassId::none };
+
+template<typename T>
+    requires requires { T::class_ids; }
+constexpr ClassIdRange class_ids<T> = T::class_ids;
+
+// One constant TypeInfo per type, named by `type_name<T>`. Defined in string.hh, since the name
+// needs a complete String.
+template<typename T>
+struct StaticTypeInfo;
+
 extern const TypeInfo int_info;
 extern const TypeInfo double_info;
 extern const TypeInfo float_info;
@@ -25,7 +173,11 @@ extern const TypeInfo char_info;
 template<typename T>
 const TypeInfo& get_type_info() noexcept
 {
-    return T::get_type_info_static();
+    if constexpr (std::is_integral_v<T>) {
+        return falafel_internal::StaticTypeInfo<T>::info;
+    } else {
+        return T::get_type_info_static();
+    }
 }
 
 template<>
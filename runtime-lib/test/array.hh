@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../src/array.hh"
+#include "../src/typedefs.hh"
+#include <test_framework.hh>
+
+testgroup (array) {
+    testcase (empty_range)
+    {
+        Array<Int> arr;
+        test_assert(arr.begin() == arr.end(), "An empty array should have an empty range");
+    }
+    , testcase (range_covers_elements)
+    {
+        Array<Int> arr { 1, 2, 3 };
+        Int sum = 0;
+        for (Int el : arr) {
+            sum += el;
+        }
+        test_assert(arr.end() - arr.begin() == 3, "Range should have one entry per element");
+        test_assert(sum == 6, "Range should visit every element");
+    }
+    , testcase (copy_is_unaffected_by_changes)
+    {
+        Array<Int> arr { 1, 2, 3 };
+        Int count = 0;
+        for (Int el : Array<Int>(arr)) {
+            arr.push(el);
+            arr._indexset(2, 10);
+            ++count;
+        }
+        test_assert(count == 3, "Changes to the original should not extend the loop");
+        test_assert(arr.length() == 6U, "Changes to the original should still happen");
+        test_assert(
+            arr._indexget(5) == 3, "The loop should see the elements from before it started"
+        );
+    }
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../src/async.hh"
+#include "../src/typedefs.hh"
+#include <stdexcept>
+#include <test_framework.hh>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+inline Task<Int> sleep_then_record(Int milliseconds, std::vector<Int>* log)
+{
+    co_await f_sleepS4Task1_ve(milliseconds);
+    log->push_back(milliseconds);
+    co_return milliseconds;
+}
+
+inline Task<Int> add_results(Task<Int> first, Task<Int> second)
+{
+    Int a = co_await first;
+    Int b = co_await second;
+    co_return a + b;
+}
+
+inline Task<Int> read_byte(int fd)
+{
+    co_await falafel_internal::ReadableAwaiter { fd };
+    char byte = 0;
+    co_return read(fd, &byte, 1U) == 1 ? byte : -1;
+}
+
+inline Task<Int> fail_after(Int milliseconds)
+{
+    co_await f_sleepS4Task1_ve(milliseconds);
+    throw std::runtime_error("failed");
+}
+
+inline Task<Int> add_one(Task<Int> task) { co_return co_await task + 1; }
+
+inline Task<Void> write_byte_later(int fd, char byte)
+{
+    co_await f_sleepS4Task1_ve(5);
+    (void)write(fd, &byte, 1U);
+}
+}
+
+testgroup (async) {
+    testcase (timers_fire_in_deadline_order)
+    {
+        std::vector<Int> log;
+        Task<Int> slow = sleep_then_record(30, &log);
+        Task<Int> fast = sleep_then_record(10, &log);
+        Task<Int> sum = add_results(slow, fast);
+
+        test_assert(!sum.is_done(), "A task should suspend while it waits");
+        test_assert(
+            falafel_internal::run_until_complete(sum) == 40, "Awaiting should give the results"
+        );
+        test_assert(log.size() == 2U && log[0] == 10 && log[1] == 30, "Timers should overlap");
+        test_assert(
+            falafel_internal::run_until_complete(fast) == 10,
+            "A finished task should keep its result"
+        );
+    }
+    , testcase (readable_waits_for_data)
+    {
+        int fds[2];
+        test_assert(pipe(fds) == 0, "Should create a pipe");
+
+        Task<Int> reader = read_byte(fds[0]);
+        write_byte_later(fds[1], 'x');
+        test_assert(!reader.is_done(), "Reading should wait for the write");
+        test_assert(
+            falafel_internal::run_until_complete(reader) == 'x', "Reading should get the byte"
+        );
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+    , testcase (event_loop_drains)
+    {
+        std::vector<Int> log;
+        sleep_then_record(1, &log);
+        falafel_internal::run_event_loop();
+        test_assert(log.size() == 1U, "Unawaited tasks should still run to completion");
+        test_assert(!falafel_internal::run_event_loop_once(), "Nothing should be left to run");
+    }
+    , testcase (errors_reach_awaiters)
+    {
+        Task<Int> failing = fail_after(5);
+        Task<Int> waiting = add_one(failing);
+        bool caught = false;
+        try {
+            falafel_internal::run_until_complete(waiting);
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        test_assert(caught, "An awaiter should get the error of the task it awaits");
+        test_assert(failing.is_done(), "A task that failed should be done");
+        test_assert(!falafel_internal::run_event_loop_once(), "Nothing should be left to run");
+    }
+    , testcase (frames_are_reused)
+    {
+        void* first = falafel_internal::allocate_frame(200U);
+        falafel_internal::free_frame(first, 200U);
+        void* second = falafel_internal::allocate_frame(220U);
+        test_assert(first == second, "Frames of the same size class should share memory");
+        falafel_internal::free_frame(second, 220U);
+    }
+};
@@ -38,6 +38,12 @@ struct VisitCounter {
         visitor(nullptr);
     }
 };
+
+struct Tracked final : public Object {
+    static inline int8_t destroyed;
+
+    inline ~Tracked() noexcept { ++destroyed; }
+};
 }
 
 testgroup (cowbuffer) {
@@ -153,4 +159,59 @@ testgroup (cowbuffer) {
         }
         Object::collect_cycles();
     }
+    , testcase (clear_keeps_shared_elements)
+    {
+        Counter::count = 0;
+        CowBuffer<Counter> cb(1U);
+        cb.length_mut() = 1U;
+        new (cb + 0) Counter();
+        test_assume(Counter::count == 1, "Should only have created one instance");
+        {
+            CowBuffer<Counter> cb2(cb);
+            cb2.clear();
+            test_assert(Counter::count == 1, "clear should not destroy shared elements");
+        }
+        test_assert(cb.length() == 1U, "Original buffer should be untouched");
+        // The copy's release left the header buffered as a possible cycle root.
+        cb.clear();
+        Object::collect_cycles();
+        test_assert(Counter::count == 0, "Last clear should destroy the elements");
+    }
+    , testcase (self_assignment_keeps_buffer)
+    {
+        Counter::count = 0;
+        CowBuffer<Counter> cb(1U);
+        cb.length_mut() = 1U;
+        new (cb + 0) Counter();
+
+        auto& self = cb;
+        test_assert(&(cb = self) == &cb, "Assignment should return the assigned buffer");
+        test_assert(Counter::count == 1, "Self-assignment should not destroy elements");
+        test_assert(cb.length() == 1U, "Self-assignment should keep the buffer");
+    }
+    , testcase (releases_object_children_once)
+    {
+        Tracked::destroyed = 0;
+        {
+            CowBuffer<RcPointer<Tracked>> cb(1U);
+            cb.length_mut() = 1U;
+            new (cb + 0) RcPointer<Tracked>(new Tracked());
+        }
+        test_assert(Tracked::destroyed == 1, "Child should be destroyed exactly once");
+    }
+    , testcase (collects_self_referencing_buffer)
+    {
+        Tracked::destroyed = 0;
+        {
+            CowBuffer<RcPointer<Object>> cb(2U);
+            cb.length_mut() = 2U;
+
+            Object* header = static_cast<Object*>(cb);
+            header->retain();
+            new (cb + 0) RcPointer<Object>(header);
+            new (cb + 1) RcPointer<Object>(new Tracked());
+        }
+        Object::collect_cycles();
+        test_assert(Tracked::destroyed == 1, "Cycle should be collected exactly once");
+    }
 };
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../src/array.hh"
+#include "../src/heapprofile.hh"
+#include "../src/refcount.hh"
+#include "../src/string.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <test_framework.hh>
+
+namespace {
+inline std::string capture(void (*write)(FILE*))
+{
+    FILE* file = tmpfile();
+    write(file);
+    std::string contents;
+    contents.resize(static_cast<size_t>(ftell(file)));
+    rewind(file);
+    contents.resize(fread(contents.data(), 1U, contents.size(), file));
+    fclose(file);
+    return contents;
+}
+
+// The byte count on the line for `type`, or 0 if there is none.
+inline size_t bytes_for_type(const std::string& types, const char* type)
+{
+    size_t end = types.find(std::string("  ") + type + "\n");
+    if (end == std::string::npos) {
+        return 0U;
+    }
+    size_t start = types.rfind(' ', end - 1U);
+    return strtoul(types.c_str() + start + 1U, nullptr, 10);
+}
+}
+
+testgroup (heapprofile) {
+    testcase (counts_array_buffers)
+    {
+        falafel_internal::heap_profile_start(1U);
+        Array<Int> array;
+        for (Int i = 0; i < 1000; ++i) {
+            array.push(i);
+        }
+        std::string types = capture(falafel_internal::heap_profile_write_types);
+        falafel_internal::heap_profile_stop();
+
+        test_assert(
+            bytes_for_type(types, "Array<Int>") >= 1000U * sizeof(Int),
+            "An array's elements should count towards its type, even after the buffer moved"
+        );
+    }
+    , testcase (forgets_destroyed_objects)
+    {
+        falafel_internal::heap_profile_start(1U);
+        {
+            RcPointer<String> string = String::empty->add(String::empty);
+            Array<Double> array(16U);
+            array.push(1.0);
+        }
+        std::string types = capture(falafel_internal::heap_profile_write_types);
+        falafel_internal::heap_profile_stop();
+
+        test_assert(
+            bytes_for_type(types, "Array<Double>") == 0U, "Destroyed objects shouldn't be counted"
+        );
+        test_assert(types.starts_with("0 live objects"), "Nothing should be left");
+    }
+    , testcase (lists_buffered_roots)
+    {
+        falafel_internal::heap_profile_start(1U);
+        RcPointer<Object> root = new Object();
+        {
+            RcPointer<Object> copy = root;
+        }
+        std::string types = capture(falafel_internal::heap_profile_write_types);
+        falafel_internal::heap_profile_stop();
+
+        char address[32];
+        snprintf(address, sizeof address, "%18p", static_cast<void*>(root));
+        size_t roots = types.find("cycle collector's root buffer");
+        test_assert(
+            roots != std::string::npos && types.find(address, roots) != std::string::npos,
+            "An object released to a nonzero count should be listed as a root"
+        );
+        Object::collect_cycles();
+    }
+    , testcase (writes_pprof_samples)
+    {
+        falafel_internal::heap_profile_start(1U);
+        RcPointer<Object> obj = new Object();
+        std::string profile = capture(falafel_internal::heap_profile_write_pprof);
+        falafel_internal::heap_profile_stop();
+
+        test_assert(profile.starts_with("heap profile: 1: "), "The object should be sampled");
+        test_assert(
+            profile.find("@ heap_v2/1\n") != std::string::npos,
+            "The header should give the sample rate"
+        );
+        test_assert(
+            profile.find("\nMAPPED_LIBRARIES:\n") != std::string::npos,
+            "The memory map should be included"
+        );
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../src/input.hh"
+#include "../src/string.hh"
+#include <cstdio>
+#include <string>
+#include <test_framework.hh>
+#include <unistd.h>
+
+namespace {
+// A temporary file holding `contents`, removed when the object is destroyed.
+class TemporaryFile {
+public:
+    inline TemporaryFile(const std::string& contents)
+    {
+        char path_template[] = "/tmp/falafel-test-XXXXXX";
+        int fd = mkstemp(path_template);
+        m_path = path_template;
+        for (size_t written = 0U; written < contents.size();) {
+            ssize_t length = write(fd, contents.data() + written, contents.size() - written);
+            if (length <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(length);
+        }
+        close(fd);
+    }
+
+    inline ~TemporaryFile() { unlink(m_path.c_str()); }
+
+    inline const std::string& path() const noexcept { return m_path; }
+
+    inline String* path_string() const
+    {
+        return String::allocate_immortal_utf8(reinterpret_cast<const char8_t*>(m_path.c_str()));
+    }
+
+private:
+    std::string m_path;
+};
+
+inline bool line_is(const Optional<RcPointer<String>>& line, const char8_t* expected)
+{
+    return line.has_value()
+        && line.or_else([] { return RcPointer<String>(); })
+               ->is_equal(String::allocate_immortal_utf8(expected));
+}
+}
+
+testgroup (input) {
+    testcase (line_iterator) {
+        LineIterator lines(
+            String::allocate_immortal_utf8(u8"first\r\n\nthird line is longer\nlast")
+        );
+        test_assert(line_is(lines.next(), u8"first"), "Should strip CRLF");
+        test_assert(line_is(lines.next(), u8""), "Should yield empty lines");
+        test_assert(line_is(lines.next(), u8"third line is longer"), "Should yield long lines");
+        test_assert(line_is(lines.next(), u8"last"), "Should yield an unterminated last line");
+        test_assert(!lines.next().has_value(), "Should stop at the end");
+
+        LineIterator terminated(String::allocate_small_utf8(u8"a\n"));
+        test_assert(line_is(terminated.next(), u8"a"), "Should yield the only line");
+        test_assert(!terminated.next().has_value(), "A final newline should not add a line");
+    }
+    , testcase (read_file)
+    {
+        std::string contents;
+        for (int i = 0; i < 10000; ++i) {
+            contents += "line number " + std::to_string(i) + "\n";
+        }
+        TemporaryFile large(contents);
+        TemporaryFile small("tiny\n");
+
+        auto mapped = String::read_file(large.path_string());
+        test_assert(mapped.has_value(), "Should read a large file");
+        RcPointer<String> text = mapped.or_else([] { return RcPointer<String>(); });
+        test_assert(text->length() == contents.size(), "Should read the whole file");
+
+        LineIterator lines(text);
+        for (int i = 0; i < 9999; ++i) {
+            lines.next();
+        }
+        test_assert(line_is(lines.next(), u8"line number 9999"), "Should iterate a mapped file");
+
+        test_assert(
+            line_is(String::read_file(small.path_string()), u8"tiny\n"),
+            "Should read a small file"
+        );
+        test_assert(
+            !String::read_file(String::allocate_immortal_utf8(u8"/nonexistent/file")).has_value(),
+            "Should return null for a missing file"
+        );
+    }
+    , testcase (read_line)
+    {
+        TemporaryFile input("a\nb\r\n" + std::string(100000U, 'x') + "\nlast");
+        int saved_stdin = dup(STDIN_FILENO);
+        FILE* file = fopen(input.path().c_str(), "r");
+        dup2(fileno(file), STDIN_FILENO);
+
+        test_assert(line_is(String::read_line(), u8"a"), "Should read the first line");
+        test_assert(line_is(String::read_line(), u8"b"), "Should strip CRLF");
+        test_assert(
+            String::read_line().or_else([] { return RcPointer<String>(); })->length() == 100000U,
+            "Should read a line longer than the buffer"
+        );
+        test_assert(line_is(String::read_line(), u8"last"), "Should read an unterminated line");
+        test_assert(!String::read_line().has_value(), "Should return null at end of input");
+
+        dup2(saved_stdin, STDIN_FILENO);
+        close(saved_stdin);
+        fclose(file);
+    }
+};
@@ -1,4 +1,12 @@
+#include "array.hh"
+#include "async.hh"
 #include "cowbuffer.hh"
+#include "heapprofile.hh"
+#include "input.hh"
+#include "output.hh"
+#include "parallel.hh"
+#include "string.hh"
+#include "stringbuilder.hh"
 #include "typeinfo.hh"
 #include <test_framework.hh>
 
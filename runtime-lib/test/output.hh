@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../src/output.hh"
+#include <cstdio>
+#include <string>
+#include <test_framework.hh>
+#include <unistd.h>
+
+namespace {
+// Redirects stdout to a temporary file for the lifetime of the object.
+class CapturedStdout {
+public:
+    inline CapturedStdout() : m_file(tmpfile()), m_saved_fd(dup(STDOUT_FILENO))
+    {
+        falafel_internal::flush_output();
+        dup2(fileno(m_file), STDOUT_FILENO);
+    }
+
+    inline ~CapturedStdout()
+    {
+        falafel_internal::flush_output_noexcept();
+        dup2(m_saved_fd, STDOUT_FILENO);
+        close(m_saved_fd);
+        fclose(m_file);
+    }
+
+    inline std::string contents() const
+    {
+        std::string result;
+        char chunk[4096];
+        ssize_t length;
+        for (off_t offset = 0; (length = pread(fileno(m_file), chunk, sizeof chunk, offset)) > 0;
+             offset += length) {
+            result.append(chunk, static_cast<size_t>(length));
+        }
+        return result;
+    }
+
+private:
+    FILE* m_file;
+    int m_saved_fd;
+};
+}
+
+testgroup (output) {
+    testcase (fully_buffered) {
+        CapturedStdout captured;
+        falafel_internal::set_output_mode(falafel_internal::OutputMode::fully_buffered);
+
+        falafel_internal::write_line(u8"hello", 5U);
+        falafel_internal::write_line(u8"world", 5U);
+        test_assert(captured.contents().empty(), "Short lines should stay in the buffer");
+
+        falafel_internal::flush_output();
+        test_assert(captured.contents() == "hello\nworld\n", "Flushing should write every line");
+    }
+    , testcase (line_buffered)
+    {
+        CapturedStdout captured;
+        falafel_internal::set_output_mode(falafel_internal::OutputMode::line_buffered);
+
+        falafel_internal::write_line(u8"hello", 5U);
+        test_assert(captured.contents() == "hello\n", "Lines should be written immediately");
+    }
+    , testcase (large_line)
+    {
+        CapturedStdout captured;
+        falafel_internal::set_output_mode(falafel_internal::OutputMode::fully_buffered);
+
+        std::u8string large(200000U, u8'x');
+        falafel_internal::write_line(u8"first", 5U);
+        falafel_internal::write_line(large.data(), large.size());
+
+        std::string expected = "first\n" + std::string(large.size(), 'x') + "\n";
+        test_assert(
+            captured.contents() == expected,
+            "A line larger than the buffer should be written along with pending output"
+        );
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../src/array.hh"
+#include "../src/parallel.hh"
+#include "../src/typedefs.hh"
+#include <test_framework.hh>
+
+namespace {
+inline Int triple(Int x) { return x * 3; }
+inline Int add(Int a, Int b) { return a + b; }
+inline Int last(Int, Int b) { return b; }
+
+inline Array<Int> count_up(Int length)
+{
+    Array<Int> result;
+    for (Int i = 0; i < length; ++i) {
+        result.push(i);
+    }
+    return result;
+}
+}
+
+testgroup (parallel) {
+    testcase (map_empty)
+    {
+        Array<Int> result = falafel_internal::parallel_map(Array<Int>(), triple);
+        test_assert(result.length() == 0U, "Mapping an empty array should give an empty array");
+    }
+    , testcase (map_covers_every_element)
+    {
+        Int length = 10 * falafel_internal::PARALLEL_GRAIN + 7;
+        Array<Int> input = count_up(length);
+        Array<Int> result = falafel_internal::parallel_map(input, triple);
+
+        test_assert(result.length() == input.length(), "Result should be as long as the input");
+        bool all_match = true;
+        for (Int i = 0; i < length; ++i) {
+            all_match = all_match && result._indexget(i) == 3 * i;
+        }
+        test_assert(all_match, "Every element should be mapped in place");
+    }
+    , testcase (reduce)
+    {
+        Int length = 10 * falafel_internal::PARALLEL_GRAIN + 7;
+        Array<Int> input = count_up(length);
+
+        test_assert(
+            falafel_internal::parallel_reduce(input, 5, add) == 5 + length * (length - 1) / 2,
+            "Reducing should combine every element and the initial value"
+        );
+        test_assert(
+            falafel_internal::parallel_reduce(input, -1, last) == length - 1,
+            "Reducing should combine elements in order"
+        );
+        test_assert(
+            falafel_internal::parallel_reduce(Array<Int>(), 5, add) == 5,
+            "Reducing an empty array should give the initial value"
+        );
+    }
+};
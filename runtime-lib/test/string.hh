@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../src/array.hh"
+#include "../src/refcount.hh"
+#include "../src/string.hh"
+#include <test_framework.hh>
+
+namespace {
+inline String* const haystack_str = String::allocate_immortal_utf8(
+    u8"It was the best of times, it was the worst of times, it was the age of wisdom, it was the "
+    u8"age of foolishness"
+);
+inline String* const was_str = String::allocate_small_utf8(u8"was");
+inline String* const foolishness_str = String::allocate_immortal_utf8(u8"foolishness");
+inline String* const wisdom_str = String::allocate_small_utf8(u8"wisdom");
+inline String* const missing_str = String::allocate_immortal_utf8(u8"age of reason");
+inline String* const comma_str = String::allocate_small_utf8(u8", ");
+inline String* const abc_str = String::allocate_small_utf8(u8"abc");
+inline String* const abd_str = String::allocate_small_utf8(u8"abd");
+inline String* const ab_str = String::allocate_small_utf8(u8"ab");
+}
+
+testgroup (string) {
+    testcase (find) {
+        test_assert(haystack_str->find(was_str) == 3, "Should find the first occurrence");
+        test_assert(haystack_str->find(wisdom_str) == 71, "Should find a match past one vector");
+        test_assert(
+            haystack_str->find(foolishness_str) == 97,
+            "Should find a match at the very end"
+        );
+        test_assert(haystack_str->find(missing_str) == -1, "Should not find a missing needle");
+        test_assert(haystack_str->find(String::empty) == 0, "Empty needle should match at 0");
+        test_assert(haystack_str->find(u8'f') == 17, "Should find a single byte");
+        test_assert(haystack_str->find(u8'z') == -1, "Should not find a missing byte");
+    }
+    , testcase (affixes)
+    {
+        test_assert(haystack_str->starts_with(abc_str) == false, "Should not match wrong prefix");
+        test_assert(
+            haystack_str->ends_with(foolishness_str),
+            "Should match the suffix 'foolishness'"
+        );
+        test_assert(abc_str->starts_with(ab_str), "'abc' should start with 'ab'");
+        test_assert(!ab_str->starts_with(abc_str), "A prefix cannot be longer than the string");
+    }
+    , testcase (count)
+    {
+        test_assert(haystack_str->count(was_str) == 4, "'was' appears four times");
+        test_assert(haystack_str->count(u8'w') == 6, "'w' appears six times");
+        test_assert(haystack_str->count(missing_str) == 0, "Missing needle appears zero times");
+    }
+    , testcase (split)
+    {
+        Array<RcPointer<String>> pieces = haystack_str->split(comma_str);
+        test_assert(pieces.length() == 4U, "Should split into four pieces");
+        test_assert(
+            pieces._indexget(0)->ends_with(String::allocate_small_utf8(u8"times")),
+            "First piece should end before the separator"
+        );
+        test_assert(
+            pieces._indexget(3)->ends_with(foolishness_str),
+            "Last piece should run to the end"
+        );
+
+        Array<RcPointer<String>> chars = abc_str->split(String::empty);
+        test_assert(chars.length() == 3U, "Empty separator should split into bytes");
+        test_assert(chars._indexget(1)->_indexget(0) == u8'b', "Second byte should be 'b'");
+    }
+    , testcase (substring)
+    {
+        RcPointer<String> parent = haystack_str->add(haystack_str);
+        test_assert(parent->is_unique(), "Fresh string should be unique");
+
+        {
+            RcPointer<String> middle = parent->substring(26, 52);
+            test_assert(
+                middle->is_equal(String::allocate_immortal_utf8(u8"it was the worst of times,")),
+                "Slice should contain the requested range"
+            );
+            test_assert(!parent->is_unique(), "Long slice should share the parent's buffer");
+
+            RcPointer<String> inner = middle->substring(7, 17);
+            test_assert(
+                inner->is_equal(String::allocate_immortal_utf8(u8"the worst ")),
+                "Slice of a slice should be relative to the slice"
+            );
+        }
+        test_assert(parent->is_unique(), "Dropping the slice should release the parent");
+
+        RcPointer<String> big = parent;
+        while (big->length() < 8192U) {
+            big = big->add(big);
+        }
+        RcPointer<String> word = big->substring(71, 91);
+        test_assert(big->is_unique(), "Tiny slice of a huge string should be copied");
+        test_assert(word->starts_with(wisdom_str), "Copied slice should have the same content");
+    }
+    , testcase (parse)
+    {
+        auto parse_int = [](const char8_t* s) {
+            return String::allocate_immortal_utf8(s)->parse_int();
+        };
+        auto parse_double = [](const char8_t* s) {
+            return String::allocate_immortal_utf8(s)->parse_double();
+        };
+
+        test_assert(
+            parse_int(u8"-9223372036854775808").or_else([] { return Int { 0 }; }) == INT64_MIN,
+            "Should parse the smallest Int"
+        );
+        test_assert(!parse_int(u8"9223372036854775808").has_value(), "Should reject overflow");
+        test_assert(!parse_int(u8"12abc").has_value(), "Should reject trailing garbage");
+        test_assert(!parse_int(u8" 12").has_value(), "Should reject leading whitespace");
+        test_assert(!parse_int(u8"").has_value(), "Should reject the empty string");
+
+        test_assert(
+            parse_double(u8"0.1").or_else([] { return 0.0; }) == 0.1,
+            "Should round to the nearest Double"
+        );
+        test_assert(
+            parse_double(u8"-1.5e-3").or_else([] { return 0.0; }) == -1.5e-3,
+            "Should parse scientific notation"
+        );
+        test_assert(!parse_double(u8"1.5.2").has_value(), "Should reject trailing garbage");
+        test_assert(!parse_double(u8"1e999").has_value(), "Should reject out-of-range numbers");
+    }
+    , testcase (compare)
+    {
+        test_assert(abc_str->compare(abd_str) < 0, "'abc' should sort before 'abd'");
+        test_assert(abd_str->compare(abc_str) > 0, "'abd' should sort after 'abc'");
+        test_assert(ab_str->compare(abc_str) < 0, "A prefix should sort first");
+        test_assert(abc_str->compare(abc_str) == 0, "A string should equal itself");
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../src/array.hh"
+#include "../src/optional.hh"
+#include "../src/stringbuilder.hh"
+#include <test_framework.hh>
+
+testgroup (stringbuilder) {
+    testcase (short) {
+        StringBuilder sb(4U);
+        sb.add_piece(static_cast<Int>(-42));
+        sb.add_piece(u8'!');
+        sb.add_piece(true);
+
+        RcPointer<String> result = sb.build();
+        test_assert(
+            result->is_equal(String::allocate_small_utf8(u8"-42!true")),
+            "Pieces should be concatenated"
+        );
+    }
+    , testcase (growth)
+    {
+        StringBuilder sb(1U);
+        for (Int i = 0; i < 1000; ++i) {
+            sb.add_piece(i % 10);
+        }
+
+        RcPointer<String> result = sb.build();
+        test_assert(result->length() == 1000U, "Builder should grow past its estimate");
+        test_assert(result->_indexget(999) == u8'9', "Content should survive reallocation");
+
+        sb.add_piece(u8'x');
+        test_assert(sb.build()->length() == 1U, "Builder should be empty after build()");
+    }
+    , testcase (numbers)
+    {
+        auto format = [](auto value) {
+            StringBuilder sb(0U);
+            sb.add_piece(value);
+            return sb.build();
+        };
+
+        test_assert(
+            format(0.1)->is_equal(String::allocate_small_utf8(u8"0.1")),
+            "Doubles should use the shortest round-trip form"
+        );
+        test_assert(
+            format(0.1f)->is_equal(String::allocate_small_utf8(u8"0.1")),
+            "Floats should use the shortest round-trip form for Float"
+        );
+        test_assert(
+            format(1e300)->is_equal(String::allocate_small_utf8(u8"1e+300")),
+            "Large values should use scientific notation"
+        );
+        test_assert(
+            format(-2.2250738585072014e-308)
+                ->is_equal(String::allocate_immortal_utf8(u8"-2.2250738585072014e-308")),
+            "The longest Double should fit"
+        );
+        test_assert(
+            format(static_cast<Int>(INT64_MIN))
+                ->is_equal(String::allocate_immortal_utf8(u8"-9223372036854775808")),
+            "The smallest Int should be formatted without overflow"
+        );
+        test_assert(
+            format(static_cast<Int>(0))->is_equal(String::allocate_small_utf8(u8"0")),
+            "Zero should be formatted as one digit"
+        );
+        test_assert(
+            format(static_cast<Int8>(-128))->is_equal(String::allocate_small_utf8(u8"-128")),
+            "Int8 should be formatted as a number, not a character"
+        );
+        test_assert(
+            format(static_cast<UInt8>(255))->is_equal(String::allocate_small_utf8(u8"255")),
+            "UInt8 should be formatted as a number, not a character"
+        );
+        test_assert(
+            format(static_cast<UInt64>(UINT64_MAX))
+                ->is_equal(String::allocate_immortal_utf8(u8"18446744073709551615")),
+            "The largest UInt64 should be formatted without a sign"
+        );
+    }
+    , testcase (collections)
+    {
+        Array<Int> numbers(3U);
+        numbers.push(1);
+        numbers.push(2);
+        numbers.push(3);
+
+        Array<Optional<Double>> optionals(2U);
+        optionals.push(Optional<Double>(0.5));
+        optionals.push(Optional<Double>());
+
+        StringBuilder sb(32U);
+        sb.add_piece(numbers);
+        sb.add_piece(u8' ');
+        sb.add_piece(optionals);
+        sb.add_piece(u8' ');
+        sb.add_piece(Array<Int>(0U));
+
+        test_assert(
+            sb.build()->is_equal(String::allocate_immortal_utf8(u8"[1, 2, 3] [0.5, null] []")),
+            "Arrays and optionals should be formatted inline"
+        );
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../src/array.hh"
+#include "../src/optional.hh"
 #include "../src/refcount.hh"
 #include "../src/string.hh"
 #include "../src/typeinfo.hh"
@@ -12,6 +13,11 @@ inline String* const string_str = String::allocate_small_utf8(u8"String");
 inline String* const double_str = String::allocate_small_utf8(u8"Double");
 inline String* const array_of_char_str = String::allocate_immortal_utf8(u8"Array<Char>");
 inline String* const array_of_string_str = String::allocate_immortal_utf8(u8"Array<String>");
+inline String* const array_of_int8_str = String::allocate_immortal_utf8(u8"Array<Int8>");
+inline String* const array_of_uint16_str = String::allocate_immortal_utf8(u8"Array<UInt16>");
+inline String* const optional_of_array_str
+    = String::allocate_immortal_utf8(u8"Optional<Array<Int>>");
+inline String* const optional_of_string_str = String::allocate_immortal_utf8(u8"Optional<String>");
 
 inline String* const subject_str = String::allocate_immortal_utf8(
     u8"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt "
@@ -74,5 +80,86 @@ testgroup (typeinfo) {
                 "Array<String> info should have name 'Array<String>'"
             );
         }
+
+        {
+            auto arr_int8_info = get_type_info<Array<Int8>>();
+            test_assert(
+                arr_int8_info.name->is_equal(array_of_int8_str),
+                "Array<Int8> info should have name 'Array<Int8>'"
+            );
+
+            auto arr_uint16_info = get_type_info<Array<UInt16>>();
+            test_assert(
+                arr_uint16_info.name->is_equal(array_of_uint16_str),
+                "Array<UInt16> info should have name 'Array<UInt16>'"
+            );
+        }
+    }
+    , testcase (optional)
+    {
+        auto& opt_arr_info = get_type_info<Optional<Array<Int>>>();
+        test_assert(
+            opt_arr_info.name->is_equal(optional_of_array_str),
+            "Optional<Array<Int>> info should have name 'Optional<Array<Int>>'"
+        );
+
+        auto& opt_str_info = get_type_info<Optional<RcPointer<String>>>();
+        test_assert(
+            opt_str_info.name->is_equal(optional_of_string_str),
+            "Optional<String> info should have name 'Optional<String>'"
+        );
+    }
+    , testcase (static_identity)
+    {
+        const TypeInfo& first = get_type_info<Array<RcPointer<String>>>();
+        const TypeInfo& second = get_type_info<Array<RcPointer<String>>>();
+        test_assert(&first == &second, "Repeated lookups should return the same info");
+        test_assert(
+            first.is_equal(get_type_info<Array<String>>()),
+            "Array<RcPointer<String>> and Array<String> should be equal"
+        );
+        test_assert(
+            !first.is_equal(get_type_info<Array<Char>>()),
+            "Array<String> and Array<Char> should not be equal"
+        );
+
+        test_assert(
+            first.hash() == falafel_internal::pjw_hash(u8"Array<String>", 13U),
+            "Precomputed hash should match the name"
+        );
+    }
+    , testcase (downcast)
+    {
+        RcPointer<Object> obj = new Object();
+        RcPointer<Object> str = static_cast<Object*>(subject_str);
+
+        test_assert(
+            get_type_info<String>().is_subclass_of(get_type_info<Object>()),
+            "String should be a subclass of Object"
+        );
+        test_assert(
+            !get_type_info<Object>().is_subclass_of(get_type_info<String>()),
+            "Object should not be a subclass of String"
+        );
+        test_assert(
+            !get_type_info<Int>().is_subclass_of(get_type_info<Object>()),
+            "Int should not be a subclass of Object"
+        );
+
+        RcPointer<String> as_string(str);
+        test_assert(
+            static_cast<String*>(as_string) == static_cast<Object*>(str),
+            "Downcasting a String should succeed"
+        );
+        test_assert(
+            static_cast<String*>(RcPointer<String>(obj)) == nullptr,
+            "Downcasting an Object to String should fail"
+        );
+
+        RcPointer<String> moved(std::move(obj));
+        test_assert(
+            static_cast<Object*>(obj) != nullptr,
+            "A failed move downcast should leave the source alone"
+        );
     }
 };